@@ -3,6 +3,7 @@
 #define DOMPASCH_TREE_REXX_ARG_ITERATOR_H
 
 #include <vector>
+#include <memory>
 
 #include "util/hashmap.h"
 #include "data/signature.h"
@@ -10,28 +11,44 @@
 
 class HtnInstance;
 
+// Immutable argument domains (one vector of eligible constants per argument position)
+// which can be shared among several iterators without copying.
+typedef std::shared_ptr<const std::vector<std::vector<int>>> EligibleArgs;
+
 class ArgIterator {
 
+public:
+    // Max. arity for which the increment is specialized at compile time.
+    static const size_t MAX_SPECIALIZED_ARITY = 4;
+
 private:
 
-    std::vector<std::vector<int>> _eligible_args;
+    int _sig_id;
+    EligibleArgs _eligible_args;
+    size_t _num_choices;
 
     struct It {
-        int _sig_id;
-        const std::vector<std::vector<int>>& _eligible_args;
-        std::vector<size_t> _counter;
+        const std::vector<std::vector<int>>* _eligible_args;
         size_t _counter_number;
+        // Position within each argument's domain (inline for small arities)
+        size_t _small_counter[MAX_SPECIALIZED_ARITY];
+        std::vector<size_t> _large_counter;
+        // Decoded arguments are written into the args of this signature
         USignature _usig;
 
+        // End (or empty) iterator: no allocations
+        It(size_t counterNumber) : _eligible_args(nullptr), _counter_number(counterNumber), _small_counter{} {}
+
         It(int sigId, const std::vector<std::vector<int>>& eligibleArgs) 
-                : _sig_id(sigId), _eligible_args(eligibleArgs), _counter(eligibleArgs.size(), 0), 
-                    _counter_number(0), _usig(_sig_id, std::vector<int>(_counter.size())) {
+                : _eligible_args(&eligibleArgs), _counter_number(0), _small_counter{},
+                    _usig(sigId, std::vector<int>(eligibleArgs.size())) {
             
-            for (size_t i = 0; i < _usig._args.size(); i++) {
-                assert(i < _eligible_args.size());
-                assert(!_eligible_args[i].empty());
-                _usig._args[i] = _eligible_args[i].front();
+            for (size_t i = 0; i < eligibleArgs.size(); i++) {
+                assert(!eligibleArgs[i].empty());
+                _usig._args[i] = eligibleArgs[i].front();
             }
+            _usig.invalidateHash();
+            if (eligibleArgs.size() > MAX_SPECIALIZED_ARITY) _large_counter.resize(eligibleArgs.size(), 0);
         }
 
         const USignature& operator*() {
@@ -39,18 +56,15 @@ private:
         }
 
         const USignature& operator++() {
-            for (size_t i = 0; i < _counter.size(); i++) {
-                if (_counter[i]+1 == _eligible_args[i].size()) {
-                    // reached max value of some position
-                    _counter[i] = 0;
-                    _usig._args[i] = _eligible_args[i].front();
-                } else {
-                    // increment and done
-                    _counter[i]++;
-                    _usig._args[i] = _eligible_args[i].at(_counter[i]);
-                    break;
-                }
+            // The arity is the same in each call, so this branch is well predictable
+            switch (_usig._args.size()) {
+            case 1: increment<1>(*_eligible_args, _small_counter, _usig._args); break;
+            case 2: increment<2>(*_eligible_args, _small_counter, _usig._args); break;
+            case 3: increment<3>(*_eligible_args, _small_counter, _usig._args); break;
+            case 4: increment<4>(*_eligible_args, _small_counter, _usig._args); break;
+            default: increment(_usig._args.size(), *_eligible_args, _large_counter.data(), _usig._args);
             }
+            _usig.invalidateHash();
             _counter_number++;
             return _usig;
         }
@@ -61,30 +75,107 @@ private:
         bool operator!=(const It& other) const {
             return !(*this == other);
         }
-
-    } _begin, _end;
+    };
 
 public:
 
     ArgIterator(int sigId, std::vector<std::vector<int>>&& eligibleArgs) : 
-            _eligible_args(std::move(eligibleArgs)),
-            _begin(sigId, _eligible_args),
-            _end(sigId, _eligible_args) {
+            ArgIterator(sigId, std::make_shared<const std::vector<std::vector<int>>>(std::move(eligibleArgs))) {}
+
+    ArgIterator(int sigId, const EligibleArgs& eligibleArgs) : 
+            _sig_id(sigId), _eligible_args(eligibleArgs) {
         
-        size_t numChoices = _eligible_args.empty() ? 0 : 1;
-        for (const auto& args : _eligible_args) numChoices *= args.size();
-        _end._counter_number = numChoices;
+        _num_choices = _eligible_args->empty() ? 0 : 1;
+        for (const auto& args : *_eligible_args) _num_choices *= args.size();
     }
 
     It begin() const {
-        return _begin;
+        if (_num_choices == 0) return It(0);
+        return It(_sig_id, *_eligible_args);
     }
 
     It end() const {
-        return _end;
+        return It(_num_choices);
+    }
+
+    // Calls f(const USignature&) for each combination of eligible arguments until f returns false.
+    // The arity is dispatched once per call, and all combinations are written into one buffer.
+    // Returns false iff the enumeration was stopped by f.
+    template <typename F>
+    static bool forEach(int sigId, const std::vector<std::vector<int>>& eligibleArgs, F&& f) {
+        switch (eligibleArgs.size()) {
+        case 0: return true;
+        case 1: return forEachFixed<1>(sigId, eligibleArgs, f);
+        case 2: return forEachFixed<2>(sigId, eligibleArgs, f);
+        case 3: return forEachFixed<3>(sigId, eligibleArgs, f);
+        case 4: return forEachFixed<4>(sigId, eligibleArgs, f);
+        default: return forEachGeneric(sigId, eligibleArgs, f);
+        }
     }
 
     static ArgIterator getFullInstantiation(const USignature& sig, HtnInstance& _htn);
+
+private:
+    // Mixed-radix increment of the counter; returns false after wrapping around entirely.
+    template <size_t N>
+    static inline bool increment(const std::vector<std::vector<int>>& eligibleArgs, size_t* counter, std::vector<int>& args) {
+        for (size_t i = 0; i < N; i++) {
+            const std::vector<int>& domain = eligibleArgs[i];
+            if (++counter[i] == domain.size()) {
+                // reached max value of some position
+                counter[i] = 0;
+                args[i] = domain[0];
+            } else {
+                // increment and done
+                args[i] = domain[counter[i]];
+                return true;
+            }
+        }
+        return false;
+    }
+    static inline bool increment(size_t arity, const std::vector<std::vector<int>>& eligibleArgs, size_t* counter, std::vector<int>& args) {
+        for (size_t i = 0; i < arity; i++) {
+            const std::vector<int>& domain = eligibleArgs[i];
+            if (++counter[i] == domain.size()) {
+                counter[i] = 0;
+                args[i] = domain[0];
+            } else {
+                args[i] = domain[counter[i]];
+                return true;
+            }
+        }
+        return false;
+    }
+
+    template <size_t N, typename F>
+    static bool forEachFixed(int sigId, const std::vector<std::vector<int>>& eligibleArgs, F& f) {
+        size_t counter[N] = {};
+        USignature sig(sigId, std::vector<int>(N));
+        for (size_t i = 0; i < N; i++) {
+            if (eligibleArgs[i].empty()) return true;
+            sig._args[i] = eligibleArgs[i][0];
+        }
+        do {
+            sig.invalidateHash();
+            if (!f((const USignature&) sig)) return false;
+        } while (increment<N>(eligibleArgs, counter, sig._args));
+        return true;
+    }
+
+    template <typename F>
+    static bool forEachGeneric(int sigId, const std::vector<std::vector<int>>& eligibleArgs, F& f) {
+        std::vector<size_t> counter(eligibleArgs.size(), 0);
+        USignature sig(sigId, std::vector<int>(eligibleArgs.size()));
+        for (size_t i = 0; i < eligibleArgs.size(); i++) {
+            if (eligibleArgs[i].empty()) return true;
+            sig._args[i] = eligibleArgs[i][0];
+        }
+        do {
+            sig.invalidateHash();
+            if (!f((const USignature&) sig)) return false;
+        } while (increment(eligibleArgs.size(), eligibleArgs, counter.data(), sig._args));
+        return true;
+    }
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,123 @@
+
+#ifndef DOMPASCH_LILOTANE_DECOMPOSITION_GRAPH_H
+#define DOMPASCH_LILOTANE_DECOMPOSITION_GRAPH_H
+
+#include <vector>
+#include <climits>
+
+#include "util/hashmap.h"
+#include "data/signature.h"
+#include "data/htn_instance.h"
+
+/*
+The lifted task -> method -> subtask graph of the domain, compiled into integers.
+For each reduction, all possible children (over all of its subtasks) are stored as
+edges whose arguments refer to positions of the parent's arguments, to constants,
+or to free variables of the child. Free variables are instantiated with variables
+from a pool which is only extended when a traversal goes deeper than all before.
+*/
+class DecompositionGraph {
+
+public:
+    struct ArgSource {
+        enum Kind : uint8_t {PARENT_ARG, CONSTANT, FREE_VARIABLE} kind;
+        // Parent argument position, constant name ID, or index of the free variable.
+        int value;
+    };
+    struct Edge {
+        int childNameId;
+        std::vector<ArgSource> args;
+        int numFreeVariables;
+    };
+
+private:
+    HtnInstance& _htn;
+
+    // Reduction name ID -> edges to all possible children.
+    NodeHashMap<int, std::vector<Edge>> _edges;
+
+    // Variables to instantiate free arguments with.
+    std::vector<int> _free_variable_pool;
+
+    // Recorded visits of traversals from normalized lifted signatures, by name ID and order.
+    NodeHashMap<int, std::vector<std::pair<USignature, int>>> _traversals[2];
+
+public:
+    DecompositionGraph(HtnInstance& htn) : _htn(htn) {
+        for (const auto& [rId, r] : _htn.getReductionTemplates()) {
+            compileReduction(r);
+        }
+    }
+
+    const std::vector<Edge>& getEdges(int reductionId) const {
+        static const std::vector<Edge> NO_EDGES;
+        auto it = _edges.find(reductionId);
+        return it == _edges.end() ? NO_EDGES : it->second;
+    }
+
+    int getFreeVariable(size_t idx) {
+        while (idx >= _free_variable_pool.size()) {
+            _free_variable_pool.push_back(_htn.nameId("?_trv" + std::to_string(_free_variable_pool.size())));
+        }
+        return _free_variable_pool[idx];
+    }
+
+    const std::vector<std::pair<USignature, int>>* getTraversal(int nameId, int order) const {
+        auto it = _traversals[order].find(nameId);
+        return it == _traversals[order].end() ? nullptr : &it->second;
+    }
+    std::vector<std::pair<USignature, int>>& recordTraversal(int nameId, int order) {
+        auto& record = _traversals[order][nameId];
+        record.clear();
+        return record;
+    }
+
+private:
+    void compileReduction(const Reduction& templ) {
+
+        // Instantiate the reduction with symbolic arguments representing the parent's argument positions
+        const int symbolBase = INT_MIN / 2;
+        std::vector<int> symbols(templ.getArguments().size());
+        for (size_t i = 0; i < symbols.size(); i++) symbols[i] = symbolBase + i;
+        Reduction r = templ.substituteRed(Substitution(templ.getArguments(), symbols));
+
+        auto& edges = _edges[templ.getNameId()];
+        for (const USignature& subtask : r.getSubtasks()) {
+            if (_htn.isAction(subtask)) {
+                addEdge(subtask, symbolBase, symbols.size(), edges);
+                continue;
+            }
+            if (!_htn.hasReductions(subtask._name_id)) continue;
+            for (int subredId : _htn.getReductionIdsOfTaskId(subtask._name_id)) {
+                const Reduction& subred = _htn.getReductionTemplate(subredId);
+                // When substituting task args of a reduction, there may be multiple possibilities
+                for (const Substitution& s : Substitution::getAll(subred.getTaskArguments(), subtask._args)) {
+                    addEdge(subred.getSignature().substitute(s), symbolBase, symbols.size(), edges);
+                }
+            }
+        }
+    }
+
+    void addEdge(const USignature& child, int symbolBase, int numSymbols, std::vector<Edge>& edges) {
+        Edge edge;
+        edge.childNameId = child._name_id;
+        edge.numFreeVariables = 0;
+        FlatHashMap<int, int> freeVariableIndices;
+        for (int arg : child._args) {
+            if (arg >= symbolBase && arg < symbolBase + numSymbols) {
+                edge.args.push_back(ArgSource{ArgSource::PARENT_ARG, arg - symbolBase});
+            } else if (_htn.isVariable(arg)) {
+                auto it = freeVariableIndices.find(arg);
+                if (it == freeVariableIndices.end()) {
+                    it = freeVariableIndices.emplace(arg, edge.numFreeVariables++).first;
+                }
+                edge.args.push_back(ArgSource{ArgSource::FREE_VARIABLE, it->second});
+            } else {
+                edge.args.push_back(ArgSource{ArgSource::CONSTANT, arg});
+            }
+        }
+        edges.push_back(std::move(edge));
+    }
+};
+
+#endif
@@ -1,82 +1,154 @@
 
 #include "fact_analysis.h"
+#include "util/timer.h"
 
-const SigSet& FactAnalysis::getPossibleFactChanges(const USignature& sig, FactInstantiationMode mode, OperationType opType) {
+FactChangesView FactAnalysis::getPossibleFactChanges(const USignature& sig, FactInstantiationMode mode, OperationType opType) {
     
     if (opType == UNKNOWN) opType = _htn.isAction(sig) ? ACTION : REDUCTION;
     
-    if (opType == ACTION) return _htn.getOpTable().getAction(sig).getEffects();
-    if (_fact_changes_cache.count(sig)) return _fact_changes_cache[sig];
+    if (opType == ACTION) return FactChangesView(_htn.getOpTable().getAction(sig).getEffects(), nullptr);
+
+    // Fact changes in terms of placeholders, substituted while iterating
+    return FactChangesView(getFactChangeTemplates(sig, mode), &sig._args);
+}
+
+const SigSet& FactAnalysis::getFactChangeTemplates(const USignature& sig, FactInstantiationMode mode) {
 
     int nameId = sig._name_id;
+    auto& factChanges = mode == FULL ? _fact_changes : _lifted_fact_changes;
+    auto it = factChanges.find(nameId);
+    if (it != factChanges.end()) return it->second;
     
     // Substitution mapping
     std::vector<int> placeholderArgs;
     USignature normSig = _htn.getNormalizedLifted(sig, placeholderArgs);
-    Substitution sFromPlaceholder(placeholderArgs, sig._args);
 
-    auto& factChanges = mode == FULL ? _fact_changes : _lifted_fact_changes;
-    if (!factChanges.count(nameId)) {
-        // Compute fact changes for origSig
-        
-        NodeHashSet<Signature, SignatureHasher> facts;
-
-        if (_htn.isActionRepetition(nameId)) {
-            // Special case: Action repetition
-            Action a = _htn.getActionFromRepetition(nameId);
-            a = a.substitute(Substitution(a.getArguments(), placeholderArgs));
-            for (const Signature& eff : a.getEffects()) {
-                facts.insert(eff);
-            }
-        } else {
-            // Normal traversal to find possible fact changes
-            _traversal.traverse(normSig.substitute(Substitution(normSig._args, placeholderArgs)), 
-            NetworkTraversal::TRAVERSE_PREORDER,
-            [&](const USignature& nodeSig, int depth) { // NOLINT
-                if (_htn.isAction(nodeSig)) {
-                    
-                    Action a;
-                    if (_htn.isActionRepetition(nameId)) {
-                        // Special case: Action repetition
-                        a = _htn.toAction(_htn.getActionNameFromRepetition(nameId), nodeSig._args);
-                    } else {
-                        a = _htn.toAction(nodeSig._name_id, nodeSig._args);
-                    }
-                    for (const Signature& eff : a.getEffects()) facts.insert(eff);
-                
-                } else if (_htn.isReductionPrimitivizable(nodeSig._name_id)) {
+    // Compute fact changes in terms of the placeholder arguments
+    NodeHashSet<Signature, SignatureHasher> facts;
 
-                    const Action& op = _htn.getReductionPrimitivization(nodeSig._name_id);
-                    Action action = op.substitute(Substitution(op.getArguments(), nodeSig._args));
-                    for (const Signature& eff : action.getEffects()) facts.insert(eff);
-                }
-            });
+    if (_htn.isActionRepetition(nameId)) {
+        // Special case: Action repetition
+        Action a = _htn.getActionFromRepetition(nameId);
+        a = a.substitute(Substitution(a.getArguments(), placeholderArgs));
+        for (const Signature& eff : a.getEffects()) {
+            facts.insert(eff);
         }
+    } else {
+        // Normal traversal to find possible fact changes
+        _traversal.traverse(normSig.substitute(Substitution(normSig._args, placeholderArgs)), 
+        NetworkTraversal::TRAVERSE_PREORDER,
+        [&](const USignature& nodeSig, int depth) { // NOLINT
+            if (_htn.isAction(nodeSig)) {
+                
+                Action a;
+                if (_htn.isActionRepetition(nameId)) {
+                    // Special case: Action repetition
+                    a = _htn.toAction(_htn.getActionNameFromRepetition(nameId), nodeSig._args);
+                } else {
+                    a = _htn.toAction(nodeSig._name_id, nodeSig._args);
+                }
+                for (const Signature& eff : a.getEffects()) facts.insert(eff);
+            
+            } else if (_htn.isReductionPrimitivizable(nodeSig._name_id)) {
 
-        // Convert result to vector
-        SigSet& liftedResult = _lifted_fact_changes[nameId];
-        SigSet& result = _fact_changes[nameId];
-        for (const Signature& sig : facts) {
-            liftedResult.insert(sig);
-            if (sig._usig._args.empty()) result.insert(sig);
-            else for (const USignature& sigGround : ArgIterator::getFullInstantiation(sig._usig, _htn)) {
-                result.emplace(sigGround, sig._negated);
+                const Action& op = _htn.getReductionPrimitivization(nodeSig._name_id);
+                Action action = op.substitute(Substitution(op.getArguments(), nodeSig._args));
+                for (const Signature& eff : action.getEffects()) facts.insert(eff);
             }
-        }
+        });
     }
 
-    // Get fact changes, substitute arguments
-    _fact_changes_cache[sig] = factChanges.at(nameId);
-    for (Signature& s : _fact_changes_cache[sig]) {
-        s.apply(sFromPlaceholder);
+    // Convert result to vector
+    SigSet& liftedResult = _lifted_fact_changes[nameId];
+    SigSet& result = _fact_changes[nameId];
+    for (const Signature& sig : facts) {
+        liftedResult.insert(sig);
+        if (sig._usig._args.empty()) result.insert(sig);
+        else for (const USignature& sigGround : ArgIterator::getFullInstantiation(sig._usig, _htn)) {
+            result.emplace(sigGround, sig._negated);
+        }
     }
-    return _fact_changes_cache[sig];
+
+    return factChanges.at(nameId);
 }
 
-void FactAnalysis::eraseCachedPossibleFactChanges(const USignature& sig) {
-    _fact_changes_cache.erase(sig);
+void FactAnalysis::precomputeFactChanges() {
+
+    float time = Timer::elapsedSeconds();
+    USigSet currentOps;
+
+    for (const auto& [nameId, a] : _htn.getActionTemplates()) {
+        getFactFrame(a.getSignature(), currentOps);
+        currentOps.clear();
+    }
+    for (const auto& [nameId, r] : _htn.getReductionTemplates()) {
+        getFactFrame(r.getSignature(), currentOps);
+        currentOps.clear();
+        // Computes lifted and ground fact changes of the reduction
+        getFactChangeTemplates(r.getSignature(), FULL);
+    }
+
+    Log::i("Precomputed fact frames of %i operators and fact changes of %i reductions in %.4fs.\n", 
+        _fact_frames.size(), _fact_changes.size(), Timer::elapsedSeconds() - time);
 }
 
+FactAnalysis::ReachableDecodings FactAnalysis::getReachableDecodings(const USignature& qFact, 
+        const std::vector<std::vector<int>>& eligibleArgs, bool negated, size_t maxCollected,
+        const std::function<bool(const USignature&)>& excluded) {
+
+    ReachableDecodings result;
+    if (eligibleArgs.empty()) return result;
+
+    // Handles a decoding which is reachable with the given polarity
+    auto onReachable = [&](const USignature& decFact) {
+        if (excluded && excluded(decFact)) return;
+        if (result.numReachable++ < maxCollected) result.decodings.push_back(decFact);
+        if (isReachable(decFact, !negated)) result.numVariant++;
+    };
+
+    size_t offset;
+    std::vector<std::vector<size_t>> projections;
+    if (!_fact_index.getProjections(qFact._name_id, eligibleArgs, offset, projections)) {
+        // Some decodings are not indexed: check each of them
+        ArgIterator::forEach(qFact._name_id, eligibleArgs, [&](const USignature& decFact) {
+            if (isReachable(decFact, negated)) onReachable(decFact);
+            return true;
+        });
+        return result;
+    }
+    for (const auto& p : projections) if (p.empty()) return result;
+
+    // Enumerate the decodings' IDs, updating the ID incrementally at each changed position
+    std::vector<size_t> counter(projections.size(), 0);
+    size_t id = offset;
+    for (const auto& p : projections) id += p[0];
+    USignature decFact(qFact._name_id, std::vector<int>(counter.size()));
+    while (true) {
+        if (isReachable(qFact._name_id, id, negated)) {
+            if (excluded || result.numReachable < maxCollected) {
+                for (size_t i = 0; i < counter.size(); i++) decFact._args[i] = eligibleArgs[i][counter[i]];
+                decFact.invalidateHash();
+                onReachable(decFact);
+            } else {
+                result.numReachable++;
+                if (isReachable(qFact._name_id, id, !negated)) result.numVariant++;
+            }
+        }
+        size_t i = 0;
+        for (; i < counter.size(); i++) {
+            id -= projections[i][counter[i]];
+            if (++counter[i] == projections[i].size()) {
+                counter[i] = 0;
+                id += projections[i][0];
+            } else {
+                id += projections[i][counter[i]];
+                break;
+            }
+        }
+        if (i == counter.size()) break;
+    }
+    return result;
+}
 
 std::vector<FlatHashSet<int>> FactAnalysis::getReducedArgumentDomains(const HtnOp& op) {
 
@@ -122,12 +194,12 @@ std::vector<FlatHashSet<int>> FactAnalysis::getReducedArgumentDomains(const HtnO
         // Check possible decodings of precondition
         bool any = false;
         bool anyValid = false;
-        for (const auto& decUSig : _htn.decodeObjects(preSig._usig, _htn.getEligibleArgs(preSig._usig, preSorts))) {
+        _htn.forEachDecoding(preSig._usig, _htn.getEligibleArgs(preSig._usig, preSorts), [&](const USignature& decUSig) {
             any = true;
             assert(_htn.isFullyGround(decUSig));
 
             // Valid?
-            if (!isReachable(decUSig, preSig._negated)) continue;
+            if (!isReachable(decUSig, preSig._negated)) return true;
             
             // Valid precondition decoding found: Increase domain of concerned variables
             anyValid = true;
@@ -137,7 +209,8 @@ std::vector<FlatHashSet<int>> FactAnalysis::getReducedArgumentDomains(const HtnO
                     domainPerVariable[opArgIdx].insert(decUSig._args[i]);
                 }
             }
-        }
+            return true;
+        });
         if (any && !anyValid) return std::vector<FlatHashSet<int>>();
     }
 
@@ -178,7 +251,9 @@ FactFrame FactAnalysis::getFactFrame(const USignature& sig, USigSet& currentOps)
             // without recursing on subtasks
             const Reduction& r = _htn.toReduction(op._name_id, op._args);
             result.preconditions = r.getPreconditions();
-            result.effects = getPossibleFactChanges(r.getSignature(), LIFTED);
+            for (const Signature& eff : getPossibleFactChanges(op, LIFTED, REDUCTION)) {
+                result.effects.insert(eff);
+            }
             //Log::d("RECURSIVE_FACT_FRAME %s\n", TOSTR(result.effects));
 
         } else {
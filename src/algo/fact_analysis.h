@@ -3,11 +3,65 @@
 #define DOMPASCH_LILOTANE_ANALYSIS_H
 
 #include "data/htn_instance.h"
+#include "data/fact_index.h"
 #include "algo/network_traversal.h"
 #include "algo/arg_iterator.h"
+#include "algo/relaxed_reachability.h"
+#include "algo/mutex_analysis.h"
 
 typedef std::function<bool(const USignature&, bool)> StateEvaluator;
 
+/*
+Read-only view on the possible fact changes of an operation. The facts are stored
+once per operator in terms of placeholder arguments (-1, ..., -n) which are replaced
+by the operation's actual arguments while iterating, so no per-operation copy is made.
+The view refers to the arguments of the given operation, which must outlive the view.
+*/
+class FactChangesView {
+
+private:
+    const SigSet* _facts;
+    // Arguments replacing the placeholders, or nullptr if the facts are used as is.
+    const std::vector<int>* _args;
+
+public:
+    class iterator {
+    private:
+        SigSet::const_iterator _it;
+        const std::vector<int>* _args;
+        Signature _current;
+    public:
+        iterator(SigSet::const_iterator it, const std::vector<int>* args) : _it(it), _args(args) {}
+
+        const Signature& operator*() {
+            if (_args == nullptr) return *_it;
+            const Signature& templ = *_it;
+            _current._usig._name_id = templ._usig._name_id;
+            _current._usig._args.resize(templ._usig._args.size());
+            for (size_t i = 0; i < templ._usig._args.size(); i++) {
+                int arg = templ._usig._args[i];
+                _current._usig._args[i] = (arg < 0 && -arg <= (int)_args->size()) ? (*_args)[-arg-1] : arg;
+            }
+            _current._usig.invalidateHash();
+            _current._negated = templ._negated;
+            return _current;
+        }
+        iterator& operator++() {
+            ++_it;
+            return *this;
+        }
+        bool operator!=(const iterator& other) const {
+            return _it != other._it;
+        }
+    };
+
+    FactChangesView(const SigSet& facts, const std::vector<int>* args) : _facts(&facts), _args(args) {}
+
+    iterator begin() const {return iterator(_facts->begin(), _args);}
+    iterator end() const {return iterator(_facts->end(), _args);}
+    size_t size() const {return _facts->size();}
+};
+
 class FactAnalysis {
 
 private:
@@ -15,25 +69,49 @@ private:
     HtnInstance& _htn;
     NetworkTraversal _traversal;
 
-    USigSet _init_state;
-    USigSet _pos_layer_facts;
-    USigSet _neg_layer_facts;
+    // Dense IDs of ground facts for the following sets.
+    FactIndex _fact_index;
+
+    FactSet _init_state;
+    FactSet _pos_layer_facts;
+    FactSet _neg_layer_facts;
+
+    FactSet _initialized_facts;
+    FactSet _relevant_facts;
+
+    // Positive reachable facts by predicate (only maintained if enabled).
+    bool _index_reachable_facts = false;
+    NodeHashMap<int, std::vector<USignature>> _init_facts_by_predicate;
+    NodeHashMap<int, std::vector<USignature>> _reachable_facts_by_predicate;
+
+    // Per predicate: number of changes to its reachable facts since the last reset.
+    FlatHashMap<int, size_t> _predicate_versions;
+    size_t _reachability_epoch = 0;
 
-    USigSet _initialized_facts;
-    USigSet _relevant_facts;
+    // Static reachability of facts under the delete relaxation (if computed).
+    RelaxedReachability _relaxed_reachability;
+    // Statically mutually exclusive facts (if computed).
+    MutexAnalysis _mutexes;
+    // Ground preconditions already checked for mutexes (see hasMutexPreconditions).
+    std::vector<const USignature*> _mutex_candidates;
 
     // Maps an (action|reduction) name 
     // to the set of (partially lifted) fact signatures
     // that might be added to the state due to this operator. 
     NodeHashMap<int, SigSet> _fact_changes; 
     NodeHashMap<int, SigSet> _lifted_fact_changes;
-    NodeHashMap<USignature, SigSet, USignatureHasher> _fact_changes_cache;
 
     NodeHashMap<int, FactFrame> _fact_frames;
 
 public:
     
-    FactAnalysis(HtnInstance& htn) : _htn(htn), _traversal(htn), _init_state(_htn.getInitState()) {
+    FactAnalysis(HtnInstance& htn) : _htn(htn), _traversal(htn), _fact_index(htn), 
+            _init_state(_fact_index), _neg_layer_facts(_fact_index), 
+            _initialized_facts(_fact_index), _relevant_facts(_fact_index), 
+            _relaxed_reachability(htn, _fact_index), _mutexes(htn) {
+        for (const USignature& fact : _htn.getInitState()) {
+            _init_state.insert(_fact_index.getId(fact), fact);
+        }
         resetReachability();
     }
 
@@ -41,6 +119,28 @@ public:
         _pos_layer_facts = _init_state;
         _neg_layer_facts.clear();
         _initialized_facts.clear();
+        _predicate_versions.clear();
+        _reachability_epoch++;
+        if (_index_reachable_facts) _reachable_facts_by_predicate = _init_facts_by_predicate;
+    }
+
+    // From now on, additionally keep the positive reachable facts of each predicate
+    // in a list which can be joined over (see getReachableFacts).
+    void enableReachableFactIndex() {
+        if (_index_reachable_facts) return;
+        _index_reachable_facts = true;
+        for (const USignature& fact : _htn.getInitState()) {
+            _init_facts_by_predicate[fact._name_id].push_back(fact);
+        }
+        _reachable_facts_by_predicate = _init_facts_by_predicate;
+    }
+    bool hasReachableFactIndex() const {
+        return _index_reachable_facts;
+    }
+    const std::vector<USignature>& getReachableFacts(int predId) const {
+        static const std::vector<USignature> NO_FACTS;
+        auto it = _reachable_facts_by_predicate.find(predId);
+        return it == _reachable_facts_by_predicate.end() ? NO_FACTS : it->second;
     }
 
     void addReachableFact(const Signature& fact) {
@@ -48,7 +148,25 @@ public:
     }
 
     void addReachableFact(const USignature& fact, bool negated) {
-        (negated ? _neg_layer_facts : _pos_layer_facts).insert(fact);
+        long id = _fact_index.getId(fact);
+        FactSet& facts = negated ? _neg_layer_facts : _pos_layer_facts;
+        if (facts.contains(id, fact)) return;
+        if (!negated && _index_reachable_facts) {
+            _reachable_facts_by_predicate[fact._name_id].push_back(fact);
+        }
+        facts.insert(id, fact);
+        _predicate_versions[fact._name_id]++;
+    }
+
+    // Returns a stamp which changes whenever the reachability of some fact
+    // of one of the given predicates changes.
+    std::pair<size_t, size_t> getReachabilityStamp(const std::vector<int>& predIds) const {
+        size_t sum = 0;
+        for (int predId : predIds) {
+            auto it = _predicate_versions.find(predId);
+            if (it != _predicate_versions.end()) sum += it->second;
+        }
+        return std::pair<size_t, size_t>(_reachability_epoch, sum);
     }
 
     bool isReachable(const Signature& fact) {
@@ -56,12 +174,31 @@ public:
     }
     
     bool isReachable(const USignature& fact, bool negated) {
+        long id = _fact_index.getId(fact);
         if (negated) {
-            return _neg_layer_facts.count(fact) || !_init_state.count(fact);
+            if (!_init_state.contains(id, fact)) return true;
+            return _neg_layer_facts.contains(id, fact) && _relaxed_reachability.isDeletable(fact, id);
         }
-        return _pos_layer_facts.count(fact);
+        return _pos_layer_facts.contains(id, fact) && _relaxed_reachability.isReachable(fact, id);
     }
 
+    struct ReachableDecodings {
+        // Number of decodings reachable with the given polarity and not excluded.
+        size_t numReachable = 0;
+        // Number of these decodings which are reachable with the opposite polarity as well.
+        size_t numVariant = 0;
+        // The first (up to maxCollected) of these decodings.
+        std::vector<USignature> decodings;
+    };
+
+    // Walks the decodings of the q-fact (given the eligible constants per argument) once
+    // and counts those which are reachable with the given polarity and not excluded.
+    // If the decodings are indexed, their IDs are computed from per-argument projections,
+    // and a decoding is only constructed if it is reachable and needs to be checked
+    // for exclusion or collected.
+    ReachableDecodings getReachableDecodings(const USignature& qFact, const std::vector<std::vector<int>>& eligibleArgs, 
+            bool negated, size_t maxCollected = 0, const std::function<bool(const USignature&)>& excluded = nullptr);
+
     bool isInvariant(const Signature& fact) {
         return isInvariant(fact._usig, fact._negated);
     }
@@ -71,33 +208,49 @@ public:
     }
 
     void addRelevantFact(const USignature& fact) {
-        _relevant_facts.insert(fact);
+        _relevant_facts.insert(_fact_index.getId(fact), fact);
     }
 
     bool isRelevant(const USignature& fact) {
-        return _relevant_facts.count(fact);
+        return _relevant_facts.contains(_fact_index.getId(fact), fact);
     }
 
-    const USigSet& getRelevantFacts() {
-        return _relevant_facts;
+    size_t getNumRelevantFacts() const {
+        return _relevant_facts.size();
     }
 
     void addInitializedFact(const USignature& fact) {
-        _initialized_facts.insert(fact);
-        if (isReachable(fact, /*negated=*/true)) {
-            _neg_layer_facts.insert(fact);
+        long id = _fact_index.getId(fact);
+        _initialized_facts.insert(id, fact);
+        if (_neg_layer_facts.contains(id, fact) || !_init_state.contains(id, fact)) {
+            _neg_layer_facts.insert(id, fact);
         }
     }
 
     bool isInitialized(const USignature& fact) {
-        return _initialized_facts.count(fact);
+        return _initialized_facts.contains(_fact_index.getId(fact), fact);
     }
 
     enum FactInstantiationMode {FULL, LIFTED};
     enum OperationType {ACTION, REDUCTION, UNKNOWN};
-    const SigSet& getPossibleFactChanges(const USignature& sig, FactInstantiationMode mode = FULL, OperationType opType = UNKNOWN);
+    FactChangesView getPossibleFactChanges(const USignature& sig, FactInstantiationMode mode = FULL, OperationType opType = UNKNOWN);
+
+    // Computes which facts are reachable at all under the delete relaxation;
+    // from then on, all other facts are considered unreachable.
+    void computeRelaxedReachability() {
+        _relaxed_reachability.compute(_htn.getInitState());
+    }
+
+    void computeMutexes() {
+        _mutexes.compute(_htn.getInitState());
+    }
+    const MutexAnalysis& getMutexes() const {
+        return _mutexes;
+    }
 
-    void eraseCachedPossibleFactChanges(const USignature& sig);
+    // Computes the fact frames and the possible fact changes of all operator templates
+    // ahead of time instead of on their first occurrence.
+    void precomputeFactChanges();
 
     SigSet inferPreconditions(const USignature& op) {
         static USigSet EMPTY_USIG_SET;
@@ -113,10 +266,10 @@ public:
         
         // Q-Fact:
         if (_htn.hasQConstants(sig)) {
-            for (const auto& decSig : _htn.decodeObjects(sig, _htn.getEligibleArgs(sig))) {
-                if (isReachable(decSig, negated)) return true;
-            }
-            return false;
+            // Stop at the first reachable decoding
+            return !_htn.forEachDecoding(sig, _htn.getEligibleArgs(sig), [&](const USignature& decSig) {
+                return !isReachable(decSig, negated);
+            });
         }
 
         return isReachable(sig, negated);
@@ -130,11 +283,35 @@ public:
         for (const Signature& pre : preconds) if (!isPseudoOrGroundFactReachable(pre)) {
             return false;
         } 
-        return true;
+        return !_mutexes.isComputed() || !hasMutexPreconditions(preconds);
+    }
+
+    // Whether two positive ground preconditions are statically mutex.
+    inline bool hasMutexPreconditions(const SigSet& preconds) {
+        _mutex_candidates.clear();
+        for (const Signature& pre : preconds) {
+            if (pre._negated || !_mutexes.hasInvariant(pre._usig._name_id)) continue;
+            if (!_htn.isFullyGround(pre._usig) || _htn.hasQConstants(pre._usig)) continue;
+            for (const USignature* other : _mutex_candidates) {
+                if (_mutexes.areMutex(pre._usig, *other)) return true;
+            }
+            _mutex_candidates.push_back(&pre._usig);
+        }
+        return false;
     }
 
 private:
+    const SigSet& getFactChangeTemplates(const USignature& sig, FactInstantiationMode mode);
     FactFrame getFactFrame(const USignature& sig, USigSet& currentOps);
+
+    // Same as isReachable for an indexed fact (id >= 0) of the given predicate.
+    inline bool isReachable(int predId, long id, bool negated) const {
+        if (negated) {
+            if (!_init_state.contains(id)) return true;
+            return _neg_layer_facts.contains(id) && _relaxed_reachability.isDeletable(predId, id);
+        }
+        return _pos_layer_facts.contains(id) && _relaxed_reachability.isReachable(predId, id);
+    }
 };
 
 #endif
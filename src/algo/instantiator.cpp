@@ -2,12 +2,15 @@
 #include <assert.h>
 #include <set>
 #include <algorithm>
+#include <climits>
 
 #include "algo/instantiator.h"
 #include "algo/arg_iterator.h"
 #include "data/htn_instance.h"
 #include "util/names.h"
 
+const int UNBOUND = INT_MIN;
+
 USigSet Instantiator::EMPTY_USIG_SET;
 
 std::vector<USignature> Instantiator::getApplicableInstantiations(const Reduction& r, int mode) {
@@ -30,199 +33,204 @@ std::vector<USignature> Instantiator::getApplicableInstantiations(const Action&
     return result;
 }
 
-const HtnOp* __op;
-struct CompArgs {
-    bool operator()(const int& a, const int& b) const {
-        return rating(a) > rating(b);
-    }
-    int rating(int arg) const {
-        int r = 0;
-        for (const Signature& pre : __op->getPreconditions()) {
-            for (int preArg : pre._usig._args) {
-                if (preArg == arg) r++;
-            } 
-        }
-        for (const Signature& eff : __op->getEffects()) {
-            for (int effArg : eff._usig._args) {
-                if (effArg == arg) r++;
-            } 
-        }
-        return r;
-    }
-};
-
 std::vector<USignature> Instantiator::instantiate(const HtnOp& op) {
-    __op = &op;
-
-    /*
-    // First try to naively ground the operation up to some limit
-    FlatHashSet<int> argsToInstantiate;
-    if (_inst_mode == INSTANTIATE_FULL) {
-        for (const int& arg : op.getArguments()) {
-            if (_htn->isVariable(arg)) argsToInstantiate.insert(arg);
+
+    // Collect the argument positions to instantiate according to the q-constant policy
+    // (without -qja, no arguments are instantiated and only the preconditions are checked)
+    std::vector<int> argIndices;
+    if (_join_arguments && _inst_mode != INSTANTIATE_NOTHING && _analysis.hasReachableFactIndex()) {
+        const auto& args = op.getArguments();
+        for (size_t i = 0; i < args.size(); i++) {
+            if (!_htn.isVariable(args[i])) continue;
+            bool instantiate = _inst_mode == INSTANTIATE_FULL;
+            if (!instantiate) {
+                // Only arguments occurring in some precondition
+                const SigSet* preSets[2] = {&op.getPreconditions(), &op.getExtraPreconditions()};
+                for (const auto& preSet : preSets) for (const Signature& pre : *preSet) {
+                    for (int preArg : pre._usig._args) if (preArg == args[i]) instantiate = true;
+                }
+            }
+            if (instantiate) argIndices.push_back(i);
         }
     }
-    std::vector<int> argsByPriority(argsToInstantiate.begin(), argsToInstantiate.end());
-    std::sort(argsByPriority.begin(), argsByPriority.end(), CompArgs());
-    */
-    std::vector<int> argIndicesByPriority;
-    /*
-    const auto& sorts = _htn.getSorts(op.getSignature()._name_id);
-    for (size_t i = 0; i < sorts.size(); i++) {
-        int arg = op.getArguments()[i];
-        if (_htn.isVariable(arg) && _htn.getConstantsOfSort(sorts[i]).size() == 1) {
-            // Argument is trivial: insert only possible constant
-            argIndicesByPriority.push_back(i); 
-        }
-    }*/
 
     // a) Try to naively ground _one single_ instantiation
     // -- if this fails, there is no valid instantiation at all
-    std::vector<USignature> inst = instantiateLimited(op, argIndicesByPriority, 1, /*returnUnfinished=*/true);
-    if (inst.empty()) return inst;
+    std::vector<USignature> inst = instantiateLimited(op, argIndices, 1, /*returnUnfinished=*/true);
+    if (inst.empty() || argIndices.empty()) return inst;
 
     // b) Try if the number of valid instantiations is below the user-defined threshold
     //    -- in that case, return that full instantiation
     if (_q_const_instantiation_limit > 0) {
-        std::vector<USignature> inst = instantiateLimited(op, argIndicesByPriority, _q_const_instantiation_limit, /*returnUnfinished=*/false);
+        std::vector<USignature> inst = instantiateLimited(op, argIndices, _q_const_instantiation_limit, /*returnUnfinished=*/false);
         if (!inst.empty()) return inst;
     }
     
-    return instantiateLimited(op, argIndicesByPriority, 0, false);
-
-    /*
-    // Collect all arguments which should be instantiated
-    FlatHashSet<int> argsToInstantiate;
-
-    // a) All variable args according to the q-constant policy
-    for (size_t i = 0; i < op.getArguments().size(); i++) {
-        const int& arg = op.getArguments().at(i);
-        if (!_htn->isVariable(arg)) continue;
-
-        if (_inst_mode == INSTANTIATE_FULL) {
+    return instantiateLimited(op, argIndices, 0, false);
+}
 
-            argsToInstantiate.insert(arg);
+std::vector<USignature> Instantiator::instantiateLimited(const HtnOp& op, const std::vector<int>& argIndices, 
+        size_t limit, bool returnUnfinished) {
 
-        } else if (_inst_mode == INSTANTIATE_PRECONDITIONS) {
+    std::vector<USignature> instantiation;
     
-            bool found = false;
-            for (const auto& pre : op.getPreconditions()) {
-                for (const int& preArg : pre._usig._args) {
-                    if (arg == preArg) {
-                        found = true;
-                        break;
-                    }
-                }
-                if (found) break;
-            }
+    if (argIndices.empty()) {
+        if (_analysis.hasValidPreconditions(op.getPreconditions()) 
+            && _analysis.hasValidPreconditions(op.getExtraPreconditions()) 
+            && _htn.hasSomeInstantiation(op.getSignature())) 
+            instantiation.emplace_back(op.getSignature());
+        return instantiation;
+    }
 
-            if (found) argsToInstantiate.insert(arg);
+    JoinState state{op, op.getArguments(), std::vector<JoinCondition>(), std::vector<int>(), 
+            limit, returnUnfinished, instantiation, false};
+    const auto& args = op.getArguments();
+    const auto& sorts = _htn.getSorts(op.getNameId());
+    for (int idx : argIndices) state.binding[idx] = UNBOUND;
+
+    // Positive preconditions over instantiated arguments become the relations to join
+    std::vector<JoinCondition> conds;
+    const SigSet* preSets[2] = {&op.getPreconditions(), &op.getExtraPreconditions()};
+    for (const auto& preSet : preSets) for (const Signature& pre : *preSet) {
+        if (pre._negated || _htn.hasQConstants(pre._usig)) continue;
+        JoinCondition cond{&pre._usig, std::vector<int>(pre._usig._args.size(), -1)};
+        bool involved = false;
+        for (size_t j = 0; j < pre._usig._args.size(); j++) {
+            for (int idx : argIndices) if (args[idx] == pre._usig._args[j]) {
+                cond.argIndices[j] = idx;
+                involved = true;
+            }
         }
+        if (involved) conds.push_back(std::move(cond));
     }
 
-    // b) All variable args whose domain is below the specified q constant threshold
-    if (_q_const_rating_factor > 0) {
-        const auto& ratings = getPreconditionRatings(op.getSignature());
-        if (_inst_mode != INSTANTIATE_FULL)
-        for (size_t argIdx = 0; argIdx < op.getArguments().size(); argIdx++) {
-            int arg = op.getArguments().at(argIdx);
-            if (!_htn->isVariable(arg)) continue;
-
-            int sort = _htn->getSorts(op.getNameId()).at(argIdx);
-            int domainSize = _htn->getConstantsOfSort(sort).size();
-            float r = ratings.at(arg);
-            if (_q_const_rating_factor*r > domainSize) {
-                argsToInstantiate.insert(arg);
+    // Join order: prefer relations with many already bound arguments, then small relations
+    std::vector<bool> bound(args.size(), false);
+    while (!conds.empty()) {
+        size_t best = 0;
+        int bestNumBound = -1;
+        size_t bestNumFacts = 0;
+        for (size_t k = 0; k < conds.size(); k++) {
+            int numBound = 0;
+            for (int idx : conds[k].argIndices) if (idx >= 0 && bound[idx]) numBound++;
+            size_t numFacts = _analysis.getReachableFacts(conds[k].sig->_name_id).size();
+            if (numBound > bestNumBound || (numBound == bestNumBound && numFacts < bestNumFacts)) {
+                best = k;
+                bestNumBound = numBound;
+                bestNumFacts = numFacts;
             }
         }
+        for (int idx : conds[best].argIndices) if (idx >= 0) bound[idx] = true;
+        state.conds.push_back(std::move(conds[best]));
+        conds.erase(conds.begin()+best);
     }
 
-    // Sort args to instantiate by their priority descendingly
-    argsByPriority = std::vector<int>(argsToInstantiate.begin(), argsToInstantiate.end());
-    std::sort(argsByPriority.begin(), argsByPriority.end(), CompArgs());
+    // Arguments not bound by any relation are enumerated over their sort
+    for (int idx : argIndices) if (!bound[idx]) {
+        state.freeArgIndices.push_back(idx);
+        if (_htn.getConstantsOfSort(sorts[idx]).empty()) return instantiation;
+    }
 
-    return instantiateLimited(op, state, argsByPriority, 0, false);
-    */
+    join(state, 0);
+    if (state.limitExceeded) return std::vector<USignature>();
+    return instantiation;
 }
 
-std::vector<USignature> Instantiator::instantiateLimited(const HtnOp& op, const std::vector<int>& argIndicesByPriority, 
-        size_t limit, bool returnUnfinished) {
+bool Instantiator::join(JoinState& state, size_t level) {
+
+    const std::vector<int>& sorts = _htn.getSorts(state.op.getNameId());
+
+    if (level < state.conds.size()) {
+        // Extend the binding by each reachable fact matching the next relation
+        const JoinCondition& cond = state.conds[level];
+        std::vector<int> newlyBound;
+        for (const USignature& fact : _analysis.getReachableFacts(cond.sig->_name_id)) {
+            if (fact._args.size() != cond.sig->_args.size()) continue;
+            bool consistent = true;
+            for (size_t j = 0; j < fact._args.size() && consistent; j++) {
+                int idx = cond.argIndices[j];
+                int val = fact._args[j];
+                if (idx < 0) {
+                    consistent = _htn.isVariable(cond.sig->_args[j]) || cond.sig->_args[j] == val;
+                } else if (state.binding[idx] == UNBOUND) {
+                    consistent = _htn.getConstantsOfSort(sorts[idx]).count(val);
+                    state.binding[idx] = val;
+                    newlyBound.push_back(idx);
+                } else {
+                    consistent = state.binding[idx] == val;
+                }
+            }
+            bool proceed = !consistent || !_analysis.isReachable(fact, /*negated=*/false) || join(state, level+1);
+            for (int idx : newlyBound) state.binding[idx] = UNBOUND;
+            newlyBound.clear();
+            if (!proceed) return false;
+        }
+        return true;
+    }
 
-    std::vector<USignature> instantiation;
-    size_t doneInstSize = argIndicesByPriority.size();
-    //Log::d("DIS=%i\n", doneInstSize);
-    
-    if (doneInstSize == 0) {
-        if (_analysis.hasValidPreconditions(op.getPreconditions()) 
-            && _analysis.hasValidPreconditions(op.getExtraPreconditions()) 
-            && _htn.hasSomeInstantiation(op.getSignature())) 
-            instantiation.emplace_back(op.getSignature());
-        //log("INST %s : %i instantiations X\n", TOSTR(op.getSignature()), instantiation.size());
-        return instantiation;
+    size_t freeLevel = level - state.conds.size();
+    if (freeLevel < state.freeArgIndices.size()) {
+        // Enumerate the next unconstrained argument
+        int idx = state.freeArgIndices[freeLevel];
+        for (int c : _htn.getConstantsOfSort(sorts[idx])) {
+            if (_htn.isQConstant(c)) continue;
+            state.binding[idx] = c;
+            bool proceed = join(state, level+1);
+            state.binding[idx] = UNBOUND;
+            if (!proceed) return false;
+        }
+        return true;
     }
 
-    std::vector<std::vector<int>> assignmentsStack;
-    assignmentsStack.push_back(std::vector<int>()); // begin with empty assignment
-    while (!assignmentsStack.empty()) {
-        const std::vector<int> assignment = assignmentsStack.back();
-        assignmentsStack.pop_back();
-        //for (int a : assignment) log("%i ", a); log("\n");
-
-        // Loop over possible choices for the next argument position
-        int argPos = argIndicesByPriority[assignment.size()];
-        int sort = _htn.getSorts(op.getNameId()).at(argPos);
-        for (int c : _htn.getConstantsOfSort(sort)) {
-
-            // Create new assignment
-            std::vector<int> newAssignment(assignment);
-            newAssignment.push_back(c);
-
-            // Create corresponding op
-            Substitution s;
-            for (size_t i = 0; i < newAssignment.size(); i++) {
-                assert(i < argIndicesByPriority.size());
-                int arg = op.getArguments()[argIndicesByPriority[i]];
-                s[arg] = newAssignment[i];
-            }
-            HtnOp newOp = op.substitute(s);
-
-            // Test validity
-            if (!_analysis.hasValidPreconditions(newOp.getPreconditions())
-                || !_analysis.hasValidPreconditions(newOp.getExtraPreconditions())) continue;
-
-            // All ok -- add to stack
-            if (newAssignment.size() == doneInstSize) {
-
-                // If there are remaining variables: 
-                // is there some valid constant for each of them?
-                if (!_htn.hasSomeInstantiation(newOp.getSignature())) continue;
-
-                // This instantiation is finished:
-                // Assemble instantiated signature
-                instantiation.emplace_back(newOp.getSignature());
-
-                if (limit > 0) {
-                    if (returnUnfinished && instantiation.size() == limit) {
-                        // Limit exceeded -- return unfinished instantiation
-                        return instantiation;
-                    }
-                    if (!returnUnfinished && instantiation.size() > limit) {
-                        // Limit exceeded -- return failure
-                        return std::vector<USignature>();
-                    }
-                }
+    // Full binding: check the remaining conditions
+    if (!hasValidPreconditions(state.op, state.binding)) return true;
+    USignature sig(state.op.getNameId(), state.binding);
+    if (!_htn.hasSomeInstantiation(sig)) return true;
+    state.result.push_back(std::move(sig));
 
-            } else {
-                // Unfinished instantiation
-                assignmentsStack.push_back(newAssignment);
-            }
+    if (state.limit > 0) {
+        if (state.returnUnfinished && state.result.size() == state.limit) {
+            // Limit reached -- return unfinished instantiation
+            return false;
+        }
+        if (!state.returnUnfinished && state.result.size() > state.limit) {
+            // Limit exceeded -- return failure
+            state.limitExceeded = true;
+            return false;
         }
     }
+    return true;
+}
 
-    __op = NULL;
+bool Instantiator::hasValidPreconditions(const HtnOp& op, const std::vector<int>& binding) {
 
-    //log("INST %s : %i instantiations\n", TOSTR(op.getSignature()), instantiation.size());
-    return instantiation;
+    const std::vector<int>& args = op.getArguments();
+    _ground_positives.clear();
+    bool checkMutexes = _analysis.getMutexes().isComputed();
+
+    const SigSet* preSets[2] = {&op.getPreconditions(), &op.getExtraPreconditions()};
+    for (const auto& preSet : preSets) for (const Signature& pre : *preSet) {
+        _substituted._usig._name_id = pre._usig._name_id;
+        _substituted._usig._args = pre._usig._args;
+        for (int& arg : _substituted._usig._args) {
+            for (size_t i = 0; i < args.size(); i++) if (args[i] == arg) {
+                arg = binding[i];
+                break;
+            }
+        }
+        _substituted._usig.invalidateHash();
+        _substituted._negated = pre._negated;
+        if (!_analysis.isPseudoOrGroundFactReachable(_substituted)) return false;
+
+        if (checkMutexes && !pre._negated && _analysis.getMutexes().hasInvariant(pre._usig._name_id)
+                && _htn.isFullyGround(_substituted._usig) && !_htn.hasQConstants(_substituted._usig)) {
+            for (const USignature& other : _ground_positives) {
+                if (_analysis.getMutexes().areMutex(_substituted._usig, other)) return false;
+            }
+            _ground_positives.push_back(_substituted._usig);
+        }
+    }
+    return true;
 }
 
 const FlatHashMap<int, float>& Instantiator::getPreconditionRatings(const USignature& opSig) {
@@ -239,7 +247,7 @@ const FlatHashMap<int, float>& Instantiator::getPreconditionRatings(const USigna
         NodeHashMap<int, std::vector<float>> ratings;
         NodeHashMap<int, std::vector<int>> numRatings;
         
-        NetworkTraversal(_htn).traverse(normSig, NetworkTraversal::TRAVERSE_PREORDER, [&](const USignature& nodeSig, int depth) {
+        _traversal.traverse(normSig, NetworkTraversal::TRAVERSE_PREORDER, [&](const USignature& nodeSig, int depth) {
 
             HtnOp op = (_htn.isAction(nodeSig) ? 
                         (HtnOp)_htn.toAction(nodeSig._name_id, nodeSig._args) : 
@@ -53,9 +53,31 @@ private:
     int _inst_mode;
     float _q_const_rating_factor;
     int _q_const_instantiation_limit;
+    bool _join_arguments;
 
     NodeHashMap<int, FlatHashMap<int, float>> _precond_ratings;
 
+    // Buffers of hasValidPreconditions.
+    Signature _substituted;
+    std::vector<USignature> _ground_positives;
+
+    // A positive precondition to join over, with the position of each of its arguments
+    // among the operation's arguments (-1 if the argument is not instantiated).
+    struct JoinCondition {
+        const USignature* sig;
+        std::vector<int> argIndices;
+    };
+    struct JoinState {
+        const HtnOp& op;
+        std::vector<int> binding;
+        std::vector<JoinCondition> conds;
+        std::vector<int> freeArgIndices;
+        size_t limit;
+        bool returnUnfinished;
+        std::vector<USignature>& result;
+        bool limitExceeded;
+    };
+
 public:
     Instantiator(Parameters& params, HtnInstance& htn, FactAnalysis& analysis) : 
             _params(params), _htn(htn), _analysis(analysis), _traversal(htn) {
@@ -69,6 +91,10 @@ public:
         }
         _q_const_rating_factor = _params.getFloatParam("qrf");
         _q_const_instantiation_limit = _params.getIntParam("qit");
+        _join_arguments = _params.isNonzero("qja");
+
+        // Instantiating arguments joins preconditions over the reachable facts
+        if (_join_arguments && _inst_mode != INSTANTIATE_NOTHING) _analysis.enableReachableFactIndex();
     }
 
     std::vector<USignature> getApplicableInstantiations(const Reduction& r, int mode = -1);
@@ -76,8 +102,12 @@ public:
 
 private:
     std::vector<USignature> instantiate(const HtnOp& op);
-    std::vector<USignature> instantiateLimited(const HtnOp& op, const std::vector<int>& argIndicesByPriority, 
+    std::vector<USignature> instantiateLimited(const HtnOp& op, const std::vector<int>& argIndices, 
             size_t limit, bool returnUnfinished);
+    // Depth-first join of the relations of the state, followed by the enumeration of its free arguments.
+    // Returns false if the instantiation was stopped due to the limit.
+    bool join(JoinState& state, size_t level);
+    bool hasValidPreconditions(const HtnOp& op, const std::vector<int>& binding);
     
     const FlatHashMap<int, float>& getPreconditionRatings(const USignature& opSig);
 };
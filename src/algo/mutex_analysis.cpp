@@ -0,0 +1,100 @@
+
+#include "mutex_analysis.h"
+#include "util/log.h"
+#include "util/timer.h"
+
+void MutexAnalysis::compute(const USigSet& initState) {
+
+    float time = Timer::elapsedSeconds();
+
+    NodeHashMap<int, std::vector<USignature>> initByPredicate;
+    for (const USignature& fact : initState) initByPredicate[fact._name_id].push_back(fact);
+
+    // Predicate -> actions which may add a fact of the predicate
+    NodeHashMap<int, std::vector<const Action*>> addingActions;
+    for (const auto& [nameId, a] : _htn.getActionTemplates()) {
+        FlatHashSet<int> addedPredicates;
+        for (const Signature& eff : a.getEffects()) {
+            if (!eff._negated) addedPredicates.insert(eff._usig._name_id);
+        }
+        for (int predId : addedPredicates) addingActions[predId].push_back(&a);
+    }
+
+    for (int predId : _htn.getPredicateIds()) {
+        size_t arity = _htn.getSorts(predId).size();
+        auto it = addingActions.find(predId);
+        for (size_t k = 0; k < arity; k++) {
+            if (!holdsInitially(predId, k, initByPredicate)) continue;
+            bool valid = true;
+            if (it != addingActions.end()) for (const Action* a : it->second) {
+                if (!isBalanced(*a, predId, k)) {
+                    valid = false;
+                    break;
+                }
+            }
+            if (valid) _invariants[predId].push_back(k);
+        }
+    }
+    _computed = true;
+
+    Log::i("Mutex analysis: %i invariants over %i predicates (%.4fs)\n", 
+        getNumInvariants(), _invariants.size(), Timer::elapsedSeconds() - time);
+}
+
+bool MutexAnalysis::holdsInitially(int predId, int k, const NodeHashMap<int, std::vector<USignature>>& initByPredicate) const {
+    auto it = initByPredicate.find(predId);
+    if (it == initByPredicate.end()) return true;
+    USigSet groups;
+    for (const USignature& fact : it->second) {
+        USignature group = fact;
+        group._args[k] = -1;
+        group.invalidateHash();
+        if (!groups.insert(std::move(group)).second) return false;
+    }
+    return true;
+}
+
+bool MutexAnalysis::isBalanced(const Action& a, int predId, int k) const {
+
+    auto sameGroup = [&](const USignature& f1, const USignature& f2) {
+        for (size_t i = 0; i < f1._args.size(); i++) {
+            if (i != (size_t)k && f1._args[i] != f2._args[i]) return false;
+        }
+        return true;
+    };
+
+    std::vector<const USignature*> adds, dels;
+    for (const Signature& eff : a.getEffects()) {
+        if (eff._usig._name_id != predId) continue;
+        (eff._negated ? dels : adds).push_back(&eff._usig);
+    }
+
+    // No two added facts may end up in the same group
+    for (size_t i = 0; i < adds.size(); i++) for (size_t j = i+1; j < adds.size(); j++) {
+        bool mayAgree = true;
+        for (size_t p = 0; p < adds[i]->_args.size(); p++) {
+            int a1 = adds[i]->_args[p], a2 = adds[j]->_args[p];
+            if (p != (size_t)k && a1 != a2 && !_htn.isVariable(a1) && !_htn.isVariable(a2)) {
+                mayAgree = false;
+                break;
+            }
+        }
+        if (mayAgree) return false;
+    }
+
+    const SigSet& pre = a.getPreconditions();
+    for (const USignature* add : adds) {
+        // Adding a fact which must already hold does not change its group
+        if (pre.count(Signature(*add, false))) continue;
+        // Otherwise, some fact of the same group which must hold is deleted
+        bool balanced = false;
+        for (const USignature* del : dels) {
+            if (sameGroup(*add, *del) && pre.count(Signature(*del, false))) {
+                balanced = true;
+                break;
+            }
+        }
+        if (!balanced) return false;
+    }
+    return true;
+}
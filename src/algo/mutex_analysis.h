@@ -0,0 +1,84 @@
+
+#ifndef DOMPASCH_LILOTANE_MUTEX_ANALYSIS_H
+#define DOMPASCH_LILOTANE_MUTEX_ANALYSIS_H
+
+#include <vector>
+
+#include "util/hashmap.h"
+#include "data/signature.h"
+#include "data/htn_instance.h"
+
+/*
+Static detection of mutually exclusive facts by lifted invariant synthesis.
+A candidate invariant is a predicate P together with a "counted" argument position k:
+For each assignment of the other arguments of P, at most one fact P(..., x_k, ...)
+holds in any reachable state. The candidate is verified on the initial state and
+on each action template: every action adding a fact of P must also delete a fact
+of P with the same other arguments which it requires as a precondition, and it must
+not add two facts of P which may agree on all other arguments.
+Each verified invariant induces a mutex group per assignment of the other arguments;
+two distinct facts in the same group are mutex.
+*/
+class MutexAnalysis {
+
+private:
+    HtnInstance& _htn;
+
+    // Predicate name ID -> counted argument positions of verified invariants.
+    NodeHashMap<int, std::vector<int>> _invariants;
+
+    bool _computed = false;
+
+public:
+    MutexAnalysis(HtnInstance& htn) : _htn(htn) {}
+
+    void compute(const USigSet& initState);
+
+    bool isComputed() const {
+        return _computed;
+    }
+    bool hasInvariant(int predId) const {
+        return _invariants.count(predId);
+    }
+
+    inline bool areMutex(const USignature& fact1, const USignature& fact2) const {
+        if (fact1._name_id != fact2._name_id || fact1 == fact2) return false;
+        auto it = _invariants.find(fact1._name_id);
+        if (it == _invariants.end()) return false;
+        for (int k : it->second) {
+            bool sameGroup = true;
+            for (size_t i = 0; i < fact1._args.size(); i++) {
+                if (i != (size_t)k && fact1._args[i] != fact2._args[i]) {
+                    sameGroup = false;
+                    break;
+                }
+            }
+            if (sameGroup) return true;
+        }
+        return false;
+    }
+
+    // Appends the keys of all mutex groups which the fact belongs to.
+    // A key is the fact itself with its counted argument replaced by -1.
+    void getGroups(const USignature& fact, std::vector<USignature>& groups) const {
+        auto it = _invariants.find(fact._name_id);
+        if (it == _invariants.end()) return;
+        for (int k : it->second) {
+            groups.push_back(fact);
+            groups.back()._args[k] = -1;
+            groups.back().invalidateHash();
+        }
+    }
+
+    size_t getNumInvariants() const {
+        size_t num = 0;
+        for (const auto& [predId, positions] : _invariants) num += positions.size();
+        return num;
+    }
+
+private:
+    bool holdsInitially(int predId, int k, const NodeHashMap<int, std::vector<USignature>>& initByPredicate) const;
+    bool isBalanced(const Action& a, int predId, int k) const;
+};
+
+#endif
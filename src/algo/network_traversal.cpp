@@ -1,66 +1,104 @@
 
+
+#include <climits>
+
 #include "network_traversal.h"
+#include "algo/decomposition_graph.h"
 #include "data/htn_instance.h"
 
 void NetworkTraversal::traverse(const USignature& opSig, TraverseOrder order, std::function<void(const USignature&, int)> onVisit) {
-   
-    FlatHashSet<USignature, USignatureHasher> seenSignatures;
-    std::vector<USignature> frontier;
-    std::vector<int> depths;
+
+    DecompositionGraph& graph = _htn->getDecompositionGraph();
+
+    // A traversal from a normalized lifted signature only depends on the signature's name:
+    // replay a recorded traversal, if present
+    bool normalized = true;
+    for (size_t argPos = 0; argPos < opSig._args.size(); argPos++) {
+        normalized &= opSig._args[argPos] == -(int)argPos-1;
+    }
+    std::vector<std::pair<USignature, int>>* record = nullptr;
+    if (normalized) {
+        auto recorded = graph.getTraversal(opSig._name_id, order);
+        if (recorded != nullptr) {
+            for (const auto& [nodeSig, depth] : *recorded) onVisit(nodeSig, depth);
+            return;
+        }
+        record = &graph.recordTraversal(opSig._name_id, order);
+    }
+
+    _seen_signatures.clear();
+    _frontier.clear();
+    _frontier_args.clear();
 
     // For each possible placeholder substitution
-    frontier.push_back(opSig);
-    depths.push_back(1);
+    _frontier.push_back(FrontierNode{opSig._name_id, 1, 0, 0});
+    _frontier_args.insert(_frontier_args.end(), opSig._args.begin(), opSig._args.end());
 
     // Traverse graph of signatures with sub-reduction relationships
-    while (!frontier.empty()) {
-        USignature nodeSig = frontier.back(); frontier.pop_back();
-        int depth = depths.back(); depths.pop_back();
-        //log("%s\n", TOSTR(nodeSig));
-
-        if (depth < 0) {
+    while (!_frontier.empty()) {
+        FrontierNode node = _frontier.back(); _frontier.pop_back();
+        _node_sig._name_id = node.nameId;
+        _node_sig._args.assign(_frontier_args.begin() + node.argsBegin, _frontier_args.end());
+        _node_sig.invalidateHash();
+        _frontier_args.resize(node.argsBegin);
+        //log("%s\n", TOSTR(_node_sig));
+
+        if (node.depth < 0) {
             // Post-order traversal: visit and pop
             assert(order == TRAVERSE_POSTORDER);
-            onVisit(nodeSig, -depth+1);
+            if (record != nullptr) record->emplace_back(_node_sig, -node.depth+1);
+            onVisit(_node_sig, -node.depth+1);
             continue;
         }
 
         // Normalize node signature arguments to compare to seen signatures
-        Substitution s;
-        for (size_t argPos = 0; argPos < nodeSig._args.size(); argPos++) {
-            int arg = nodeSig._args[argPos];
+        _norm_sig._name_id = _node_sig._name_id;
+        _norm_sig._args.resize(_node_sig._args.size());
+        for (size_t argPos = 0; argPos < _node_sig._args.size(); argPos++) {
+            int arg = _node_sig._args[argPos];
+            _norm_sig._args[argPos] = arg;
             if (arg > 0 && _htn->isVariable(arg)) {
-                // Variable
-                if (!s.count(arg)) s[arg] = _htn->nameId(std::string("??_") + std::to_string(argPos));
+                // Variable: represent by the position of its first occurrence
+                size_t firstPos = 0;
+                while (_node_sig._args[firstPos] != arg) firstPos++;
+                _norm_sig._args[argPos] = INT_MIN + firstPos;
             }
         }
-        USignature normNodeSig = nodeSig.substitute(s);
+        _norm_sig.invalidateHash();
 
         // Already saw this signature?
-        if (seenSignatures.count(normNodeSig)) continue;
+        if (_seen_signatures.count(_norm_sig)) continue;
         
         if (order == TRAVERSE_PREORDER) {
             // Visit node (using "original" signature)
-            onVisit(nodeSig, depth-1);
+            if (record != nullptr) record->emplace_back(_node_sig, node.depth-1);
+            onVisit(_node_sig, node.depth-1);
         } else {
             // Remember node to be visited after all children have been visited
-            frontier.push_back(nodeSig);
-            depths.push_back(-depth+1);
+            _frontier.push_back(FrontierNode{node.nameId, -node.depth+1, node.numUsedFreeVariables, _frontier_args.size()});
+            _frontier_args.insert(_frontier_args.end(), _node_sig._args.begin(), _node_sig._args.end());
         }
 
         // Add to seen signatures
-        seenSignatures.insert(normNodeSig);
-
-        // Expand node, add children to frontier
-        for (const USignature& child : getPossibleChildren(nodeSig)) {
-            // Arguments need to be renamed on recursive domains
-            Substitution s;
-            for (int arg : child._args) {
-                if (arg > 0) s[arg] = _htn->nameId(_htn->toString(arg) + "_");
+        _seen_signatures.insert(_norm_sig);
+
+        if (!_htn->isReduction(_node_sig)) continue;
+
+        // Expand node, add children to frontier: free arguments of a child
+        // are assigned variables which do not occur in the node itself
+        for (const auto& edge : graph.getEdges(node.nameId)) {
+            _frontier.push_back(FrontierNode{edge.childNameId, node.depth, 
+                    node.numUsedFreeVariables + edge.numFreeVariables, _frontier_args.size()});
+            for (const auto& src : edge.args) {
+                switch (src.kind) {
+                case DecompositionGraph::ArgSource::PARENT_ARG:
+                    _frontier_args.push_back(_node_sig._args[src.value]); break;
+                case DecompositionGraph::ArgSource::CONSTANT:
+                    _frontier_args.push_back(src.value); break;
+                case DecompositionGraph::ArgSource::FREE_VARIABLE:
+                    _frontier_args.push_back(graph.getFreeVariable(node.numUsedFreeVariables + src.value)); break;
+                }
             }
-            frontier.push_back(child.substitute(s));
-            depths.push_back(depth);
-            //log("-> %s\n", TOSTR(child));
         }
     }
 }
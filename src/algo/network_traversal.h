@@ -15,8 +15,24 @@ public:
 
 
 private:
+    struct FrontierNode {
+        int nameId;
+        int depth;
+        // Number of free variables from the pool which may occur in the node.
+        int numUsedFreeVariables;
+        // Start of the node's arguments in _frontier_args (which extend to the end).
+        size_t argsBegin;
+    };
+
     HtnInstance* _htn;
 
+    // Buffers reused across traversals.
+    std::vector<FrontierNode> _frontier;
+    std::vector<int> _frontier_args;
+    USigSet _seen_signatures;
+    USignature _node_sig;
+    USignature _norm_sig;
+
 public:
     NetworkTraversal(HtnInstance& htn) : _htn(&htn) {}
     void traverse(const USignature& opSig, TraverseOrder order, std::function<void(const USignature&, int)> onVisit);
@@ -93,13 +93,21 @@ void PlanWriter::outputPlan(Plan& _plan) {
     }
     stream << "<==\n";
 
-    // Feed plan into parser to convert it into a plan to the original problem
-    // (w.r.t. previous compilations the parser did)
-    std::ostringstream outstream;
-    convert_plan(stream, outstream);
-    std::string planStr = outstream.str();
+    std::string planStr;
+    if (_htn.hasParsedProblem()) {
+        // Feed plan into parser to convert it into a plan to the original problem
+        // (w.r.t. previous compilations the parser did)
+        std::ostringstream outstream;
+        convert_plan(stream, outstream);
+        planStr = outstream.str();
+    } else {
+        // Instance was loaded from a snapshot without parsing: output plan as is
+        Log::w("No parsed problem available: plan is not converted back by pandaPIparser.\n");
+        planStr = stream.str();
+        planStr.resize(planStr.size() - std::string("<==\n").size());
+    }
 
-    if (_params.isNonzero("vp")) {
+    if (_params.isNonzero("vp") && _htn.hasParsedProblem()) {
         // Verify plan (by copying converted plan stream and putting it back into panda)
         std::stringstream verifyStream;
         verifyStream << planStr << std::endl;
@@ -227,6 +227,7 @@ void Planner::createFirstLayer() {
     _pos = 0;
     _enc.encode(_layer_idx, _pos++);
     _enc.encode(_layer_idx, _pos++);
+    _enc.encodeDeferredClauses();
     initLayer.consolidate();
 }
 
@@ -261,6 +262,7 @@ void Planner::createNextLayer() {
                     (*_layers[_layer_idx])[_pos].getPosFactSupports().size() + (*_layers[_layer_idx])[_pos].getNegFactSupports().size()
             );
             if (_pos > 0) _layers[_layer_idx]->at(_pos-1).clearAfterInstantiation();
+            _htn.getOpTable().trimCache();
 
             incrementPosition();
             checkTermination();
@@ -268,7 +270,7 @@ void Planner::createNextLayer() {
     }
     if (_pos > 0) _layers[_layer_idx]->at(_pos-1).clearAfterInstantiation();
 
-    Log::i("Collected %i relevant facts at this layer\n", _analysis.getRelevantFacts().size());
+    Log::i("Collected %i relevant facts at this layer\n", _analysis.getNumRelevantFacts());
 
     // Encode new layer
     Log::i("Encoding ...\n");
@@ -279,7 +281,21 @@ void Planner::createNextLayer() {
             _pos = newPos + offset;
             Log::v("- Position (%i,%i)\n", _layer_idx, _pos);
             _enc.encode(_layer_idx, _pos);
-            clearDonePositions(offset);
+            if (!_enc.defersClauses()) clearDonePositions(offset);
+            _htn.getOpTable().trimCache();
+        }
+    }
+    if (_enc.defersClauses()) {
+        // The deferred clauses of a position refer to its left and above neighbors:
+        // only free memory after all of them have been encoded
+        _enc.encodeDeferredClauses();
+        for (_old_pos = 0; _old_pos < oldLayer.size(); _old_pos++) {
+            size_t newPos = oldLayer.getSuccessorPos(_old_pos);
+            size_t maxOffset = oldLayer[_old_pos].getMaxExpansionSize();
+            for (size_t offset = 0; offset < maxOffset; offset++) {
+                _pos = newPos + offset;
+                clearDonePositions(offset);
+            }
         }
     }
 
@@ -356,7 +372,6 @@ void Planner::createNextPositionFromLeft(Position& left) {
                     // Impossible indirect effect: ignore.
                 }
             }
-            _analysis.eraseCachedPossibleFactChanges(aSig);
         }
         isAction = false;
     }
@@ -387,37 +402,24 @@ void Planner::addPreconditionsAndConstraints(const USignature& op, const SigSet&
     
     USignature constrOp = isRepetition ? USignature(_htn.getActionNameFromRepetition(op._name_id), op._args) : op;
 
+    // Ground preconditions which decodings of q-fact preconditions must not be mutex with
+    std::vector<const USignature*> groundPreconditions;
+    if (_analysis.getMutexes().isComputed()) for (const Signature& fact : preconditions) {
+        if (!fact._negated && _analysis.getMutexes().hasInvariant(fact._usig._name_id) 
+                && !_htn.hasQConstants(fact._usig)) 
+            groundPreconditions.push_back(&fact._usig);
+    }
+
     for (const Signature& fact : preconditions) {
-        auto cOpt = addPrecondition(op, fact, !isRepetition);
+        auto cOpt = addPrecondition(op, fact, groundPreconditions, !isRepetition);
         if (cOpt) newPos.addSubstitutionConstraint(constrOp, std::move(cOpt.value()));
     }
+    // (Substitution constraints are merged as far as possible upon insertion)
     if (!isRepetition) addQConstantTypeConstraints(op);
-
-    if (!newPos.getSubstitutionConstraints().count(op)) return;
-
-    // Merge substitution constraints as far as possible
-    auto& constraints = newPos.getSubstitutionConstraints().at(op);
-    //Log::d("MERGE? %i constraints\n", constraints.size());
-    for (size_t i = 0; i < constraints.size(); i++) {
-        for (size_t j = i+1; j < constraints.size(); j++) {
-            auto& iTree = constraints[i];
-            auto& jTree = constraints[j];
-            if (iTree.canMerge(jTree)) {
-                //Log::d("MERGE %s %i,%i sizes %i,%i\n", 
-                //    iTree.getPolarity() == SubstitutionConstraint::ANY_VALID ? "ANY_VALID" : "NO_INVALID", 
-                //    i, j, iTree.getEncodedSize(), jTree.getEncodedSize());
-                iTree.merge(std::move(jTree));
-                //Log::d("MERGED: new size %i\n", iTree.getEncodedSize());
-                if (j+1 < constraints.size()) 
-                    constraints[j] = std::move(constraints.back());
-                constraints.erase(constraints.begin()+constraints.size()-1);
-                j--;
-            }
-        }
-    }
 }
 
-std::optional<SubstitutionConstraint> Planner::addPrecondition(const USignature& op, const Signature& fact, bool addQFact) {
+std::optional<SubstitutionConstraint> Planner::addPrecondition(const USignature& op, const Signature& fact, 
+        const std::vector<const USignature*>& groundPreconditions, bool addQFact) {
 
     Position& pos = (*_layers[_layer_idx])[_pos];
     const USignature& factAbs = fact.getUnsigned();
@@ -444,45 +446,78 @@ std::optional<SubstitutionConstraint> Planner::addPrecondition(const USignature&
     
     auto eligibleArgs = _htn.getEligibleArgs(factAbs, sorts);
 
-    auto polarity = SubstitutionConstraint::UNDECIDED;
-    size_t totalSize = 1; for (auto& args : eligibleArgs) totalSize *= args.size();
-    size_t sampleSize = 25;
-    bool doSample = totalSize > 2*sampleSize;
-    if (doSample) {
-        size_t valids = 0;
-        // Check out a random sample of the possible decoded objects
-        for (const USignature& decFactAbs : _htn.decodeObjects(factAbs, eligibleArgs, sampleSize)) {
-            if (_analysis.isReachable(decFactAbs, fact._negated)) valids++;
+    auto isPossible = [&](const USignature& decFactAbs) {
+        if (!_analysis.isReachable(decFactAbs, fact._negated)) return false;
+        // A decoding mutex with a ground precondition of the operation can never hold
+        if (!fact._negated) for (const USignature* pre : groundPreconditions) {
+            if (_analysis.getMutexes().areMutex(decFactAbs, *pre)) return false;
         }
-        polarity = valids < sampleSize/2 ? SubstitutionConstraint::ANY_VALID : SubstitutionConstraint::NO_INVALID;
-        c.fixPolarity(polarity);
-    }
+        return true;
+    };
 
-    // For each fact decoded from the q-fact:
-    for (const USignature& decFactAbs : _htn.decodeObjects(factAbs, eligibleArgs)) {
+    auto onDecoding = [&](const USignature& decFactAbs) {
 
         // Can the decoded fact occur as is?
-        if (_analysis.isReachable(decFactAbs, fact._negated)) {
-            if (polarity != SubstitutionConstraint::NO_INVALID)
+        if (isPossible(decFactAbs)) {
+            if (c.getPolarity() != SubstitutionConstraint::NO_INVALID)
                 c.addValid(SubstitutionConstraint::decodingToPath(factAbs._args, decFactAbs._args, sortedArgIndices));
         } else {
             // Fact cannot hold here
-            if (polarity != SubstitutionConstraint::ANY_VALID)
+            if (c.getPolarity() != SubstitutionConstraint::ANY_VALID)
                 c.addInvalid(SubstitutionConstraint::decodingToPath(factAbs._args, decFactAbs._args, sortedArgIndices));
-            continue;
+            return true;
         }
 
         // If the fact is reachable, is it even invariant?
         if (_analysis.isInvariant(decFactAbs, fact._negated)) {
             // Yes! This precondition is trivially satisfied 
             // with above substitution restrictions
-            continue;
+            return true;
         }
 
         staticallyResolvable = false;
         relevants.insert(decFactAbs);
+        return true;
+    };
+
+    size_t totalSize = 1; for (auto& args : *eligibleArgs) totalSize *= args.size();
+    bool decideUpfront = totalSize > 50;
+    bool enumerated = false;
+    if (decideUpfront) {
+        // Count the possible decodings exactly and only encode the smaller side:
+        // ANY_VALID encodes the valid decodings, NO_INVALID the invalid ones.
+        // The valid decodings are collected as long as ANY_VALID is still possible.
+        bool mutexRelevant = false;
+        if (!fact._negated && _analysis.getMutexes().hasInvariant(factAbs._name_id)) {
+            for (const USignature* pre : groundPreconditions) 
+                if (pre->_name_id == factAbs._name_id) mutexRelevant = true;
+        }
+        std::function<bool(const USignature&)> isMutex;
+        if (mutexRelevant) isMutex = [&](const USignature& decFactAbs) {
+            for (const USignature* pre : groundPreconditions) 
+                if (_analysis.getMutexes().areMutex(decFactAbs, *pre)) return true;
+            return false;
+        };
+        auto reachable = _analysis.getReachableDecodings(factAbs, *eligibleArgs, fact._negated, totalSize/2, isMutex);
+        size_t numValids = reachable.numReachable;
+        c.fixPolarity(2*numValids <= totalSize ? SubstitutionConstraint::ANY_VALID : SubstitutionConstraint::NO_INVALID);
+
+        // No valid decoding: nothing to enumerate, the operation is impossible
+        if (numValids == 0) return std::optional<SubstitutionConstraint>(std::move(c));
+        // All decodings valid and invariant: nothing to encode at all
+        if (numValids == totalSize && reachable.numVariant == 0)
+            return std::optional<SubstitutionConstraint>(std::move(c));
+
+        if (c.getPolarity() == SubstitutionConstraint::ANY_VALID) {
+            // Only the valid decodings need to be visited, and all of them have been collected
+            for (const USignature& decFactAbs : reachable.decodings) onDecoding(decFactAbs);
+            enumerated = true;
+        }
     }
 
+    // For each fact decoded from the q-fact:
+    if (!enumerated) _htn.forEachDecoding(factAbs, eligibleArgs, onDecoding);
+
     if (!staticallyResolvable) {
         if (addQFact) pos.addQFact(factAbs);
         for (const USignature& decFactAbs : relevants) {
@@ -493,7 +528,7 @@ std::optional<SubstitutionConstraint> Planner::addPrecondition(const USignature&
         }
     } // else : encoding the precondition is not necessary!
 
-    if (!doSample) c.fixPolarity();
+    if (!decideUpfront) c.fixPolarity();
     return std::optional<SubstitutionConstraint>(std::move(c));
 }
 
@@ -532,16 +567,17 @@ bool Planner::addEffect(const USignature& opSig, const Signature& fact, EffectMo
     for (size_t i = 0; i < sortedArgIndices.size(); i++) involvedQConsts[i] = factAbs._args[sortedArgIndices[i]];
     std::vector<SubstitutionConstraint*> fittingConstrs, otherConstrs;
     if (isConstrained) {
+        left.findSubstitutionConstraints(opSig, involvedQConsts, fittingConstrs);
         for (auto& c : left.getSubstitutionConstraints().at(opSig)) {
-            if (c.getInvolvedQConstants() == involvedQConsts) fittingConstrs.push_back(&c);
-            else if (c.getPolarity() == SubstitutionConstraint::NO_INVALID || c.involvesSupersetOf(involvedQConsts)) 
+            if (std::find(fittingConstrs.begin(), fittingConstrs.end(), &c) != fittingConstrs.end()) continue;
+            if (c.getPolarity() == SubstitutionConstraint::NO_INVALID || c.involvesSupersetOf(involvedQConsts)) 
                 otherConstrs.push_back(&c);
         }
     }
     
     bool anyGood = false;
     bool staticallyResolvable = true;
-    for (const USignature& decFactAbs : _htn.decodeObjects(factAbs, _htn.getEligibleArgs(factAbs, sorts))) {
+    _htn.forEachDecoding(factAbs, _htn.getEligibleArgs(factAbs, sorts), [&](const USignature& decFactAbs) {
 
         auto path = SubstitutionConstraint::decodingToPath(factAbs._args, decFactAbs._args, sortedArgIndices);
 
@@ -560,13 +596,13 @@ bool Planner::addEffect(const USignature& opSig, const Signature& fact, EffectMo
                     break;
                 }
             }
-            if (!isValid) continue;
+            if (!isValid) return true;
         }
 
         anyGood = true;
         if (_analysis.isInvariant(decFactAbs, fact._negated)) {
             // Effect holds trivially
-            continue;
+            return true;
         }
 
         // Valid effect decoding
@@ -581,7 +617,8 @@ bool Planner::addEffect(const USignature& opSig, const Signature& fact, EffectMo
             _analysis.addRelevantFact(decFactAbs);
         }
         staticallyResolvable = false;
-    }
+        return true;
+    });
     // Not a single valid decoding of the effect? -> Invalid effect.
     if (!anyGood) return false;
 
@@ -741,6 +778,12 @@ std::vector<USignature> Planner::instantiateAllActionsOfTask(const USignature& t
     std::vector<USignature> result;
 
     if (!_htn.isAction(task)) return result;
+
+    // Reuse the previous instantiation if no relevant reachability changed since
+    auto stamp = _analysis.getReachabilityStamp(getPreconditionPredicates(task._name_id));
+    auto memoIt = _action_instantiations.find(task);
+    if (memoIt != _action_instantiations.end() && memoIt->second.stamp == stamp) 
+        return memoIt->second.result;
     
     for (USignature& sig : _instantiator.getApplicableInstantiations(_htn.toAction(task._name_id, task._args))) {
         //Log::d("ADDACTION %s ?\n", TOSTR(action.getSignature()));
@@ -763,6 +806,10 @@ std::vector<USignature> Planner::instantiateAllActionsOfTask(const USignature& t
         _htn.getOpTable().addAction(action);
         result.push_back(action.getSignature());
     }
+
+    // Results with q-constants of this position cannot be reused elsewhere
+    if (!introducesQConstants(task, result)) _action_instantiations[task] = InstantiationMemo{stamp, result};
+    else if (memoIt != _action_instantiations.end()) _action_instantiations.erase(memoIt);
     return result;
 }
 
@@ -771,6 +818,12 @@ std::vector<USignature> Planner::instantiateAllReductionsOfTask(const USignature
 
     if (!_htn.hasReductions(task._name_id)) return result;
 
+    // Reuse the previous instantiation if no relevant reachability changed since
+    auto stamp = _analysis.getReachabilityStamp(getPreconditionPredicates(task._name_id));
+    auto memoIt = _reduction_instantiations.find(task);
+    if (memoIt != _reduction_instantiations.end() && memoIt->second.stamp == stamp) 
+        return memoIt->second.result;
+
     // Filter and minimally instantiate methods
     // applicable in current (super)state
     for (int redId : _htn.getReductionIdsOfTaskId(task._name_id)) {
@@ -803,9 +856,39 @@ std::vector<USignature> Planner::instantiateAllReductionsOfTask(const USignature
             }
         }
     }
+
+    // Results with q-constants of this position cannot be reused elsewhere
+    if (!introducesQConstants(task, result)) _reduction_instantiations[task] = InstantiationMemo{stamp, result};
+    else if (memoIt != _reduction_instantiations.end()) _reduction_instantiations.erase(memoIt);
     return result;
 }
 
+const std::vector<int>& Planner::getPreconditionPredicates(int taskId) {
+    auto it = _precondition_predicates_of_task.find(taskId);
+    if (it != _precondition_predicates_of_task.end()) return it->second;
+
+    FlatHashSet<int> predIds;
+    auto collect = [&](const HtnOp& op) {
+        for (const Signature& pre : op.getPreconditions()) predIds.insert(pre._usig._name_id);
+        for (const Signature& pre : op.getExtraPreconditions()) predIds.insert(pre._usig._name_id);
+    };
+    auto actionIt = _htn.getActionTemplates().find(taskId);
+    if (actionIt != _htn.getActionTemplates().end()) collect(actionIt->second);
+    if (_htn.hasReductions(taskId)) for (int redId : _htn.getReductionIdsOfTaskId(taskId)) {
+        collect(_htn.getReductionTemplate(redId));
+        if (_htn.isReductionPrimitivizable(redId)) collect(_htn.getReductionPrimitivization(redId));
+    }
+    return _precondition_predicates_of_task[taskId] = std::vector<int>(predIds.begin(), predIds.end());
+}
+
+bool Planner::introducesQConstants(const USignature& task, const std::vector<USignature>& ops) {
+    for (const USignature& op : ops) for (int arg : op._args) {
+        if (_htn.isQConstant(arg) && std::find(task._args.begin(), task._args.end(), arg) == task._args.end()) 
+            return true;
+    }
+    return false;
+}
+
 std::optional<Reduction> Planner::createValidReduction(const USignature& sig, const USignature& task) {
     std::optional<Reduction> rOpt;
 
@@ -837,7 +920,7 @@ void Planner::initializeNextEffects() {
     bool isAction = true;
     for (const auto& set : ops) {
         for (const auto& aSig : *set) {
-            const SigSet& pfc = _analysis.getPossibleFactChanges(aSig, FactAnalysis::FULL, isAction ? FactAnalysis::ACTION : FactAnalysis::REDUCTION);
+            FactChangesView pfc = _analysis.getPossibleFactChanges(aSig, FactAnalysis::FULL, isAction ? FactAnalysis::ACTION : FactAnalysis::REDUCTION);
             for (const Signature& eff : pfc) {
 
                 if (!_htn.hasQConstants(eff._usig)) {
@@ -845,10 +928,11 @@ void Planner::initializeNextEffects() {
                     initializeFact(newPos, eff._usig); 
                 } else {
                     std::vector<int> sorts = _htn.getOpSortsForCondition(eff._usig, aSig);
-                    for (const USignature& decEff : _htn.decodeObjects(eff._usig, _htn.getEligibleArgs(eff._usig, sorts))) {           
+                    _htn.forEachDecoding(eff._usig, _htn.getEligibleArgs(eff._usig, sorts), [&](const USignature& decEff) {
                         // New ground fact: set before the action may happen
                         initializeFact(newPos, decEff);
-                    }
+                        return true;
+                    });
                 }
             }
         }
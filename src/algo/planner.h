@@ -52,6 +52,16 @@ private:
     bool _has_plan;
     Plan _plan;
 
+    // Instantiations of tasks, reused as long as the reachability stamp of the 
+    // predicates in the preconditions of the task's operators is unchanged.
+    struct InstantiationMemo {
+        std::pair<size_t, size_t> stamp;
+        std::vector<USignature> result;
+    };
+    NodeHashMap<USignature, InstantiationMemo, USignatureHasher> _action_instantiations;
+    NodeHashMap<USignature, InstantiationMemo, USignatureHasher> _reduction_instantiations;
+    NodeHashMap<int, std::vector<int>> _precondition_predicates_of_task;
+
     // statistics
     size_t _num_instantiated_positions = 0;
     size_t _num_instantiated_actions = 0;
@@ -70,7 +80,20 @@ public:
             _optimization_factor(_params.getFloatParam("of")), _has_plan(false) {
 
         // Mine additional preconditions for reductions from their subtasks
-        PreconditionInference::infer(_htn, _analysis, PreconditionInference::MinePrecMode(_params.getIntParam("mp")));
+        // (already contained in the templates if loaded from a snapshot)
+        if (!_htn.isLoadedFromSnapshot())
+            PreconditionInference::infer(_htn, _analysis, PreconditionInference::MinePrecMode(_params.getIntParam("mp")));
+
+        if (_params.isSet("snapshot-out")) _htn.writeSnapshot(_params.getParam("snapshot-out"));
+
+        // Statically restrict the reachable facts by a delete-relaxed fixpoint
+        if (_params.isNonzero("rrp")) _analysis.computeRelaxedReachability();
+
+        // Detect statically mutually exclusive facts
+        if (_params.getIntParam("mtx") > 0) _analysis.computeMutexes();
+
+        // Compute fact frames and fact changes of all operators up front
+        if (_params.isNonzero("pfc")) _analysis.precomputeFactChanges();
     }
     int findPlan();
     void improvePlan(int& iteration);
@@ -92,7 +115,8 @@ private:
 
     void addPreconditionConstraints();
     void addPreconditionsAndConstraints(const USignature& op, const SigSet& preconditions, bool isActionRepetition);
-    std::optional<SubstitutionConstraint> addPrecondition(const USignature& op, const Signature& fact, bool addQFact = true);
+    std::optional<SubstitutionConstraint> addPrecondition(const USignature& op, const Signature& fact, 
+            const std::vector<const USignature*>& groundPreconditions, bool addQFact = true);
     
     enum EffectMode { INDIRECT, DIRECT, DIRECT_NO_QFACT };
     bool addEffect(const USignature& op, const Signature& fact, EffectMode mode);
@@ -104,6 +128,8 @@ private:
     void propagateReductions(size_t offset);
     std::vector<USignature> instantiateAllActionsOfTask(const USignature& task);
     std::vector<USignature> instantiateAllReductionsOfTask(const USignature& task);
+    const std::vector<int>& getPreconditionPredicates(int taskId);
+    bool introducesQConstants(const USignature& task, const std::vector<USignature>& ops);
     void initializeNextEffects();
     void initializeFact(Position& newPos, const USignature& fact);
     void addQConstantTypeConstraints(const USignature& op);
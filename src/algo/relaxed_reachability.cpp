@@ -0,0 +1,278 @@
+
+#include <climits>
+#include <algorithm>
+
+#include "relaxed_reachability.h"
+#include "util/log.h"
+#include "util/names.h"
+#include "util/timer.h"
+
+const int UNBOUND = INT_MIN;
+
+void RelaxedReachability::compute(const USigSet& initState) {
+
+    float time = Timer::elapsedSeconds();
+    for (const USignature& fact : initState) addReachable(fact);
+
+    FlatHashSet<int> abortedActions;
+    int numRounds = 0;
+    do {
+        _last_changed_predicates = std::move(_changed_predicates);
+        _changed_predicates.clear();
+
+        // Facts reached in the last round are new, all earlier ones are old;
+        // facts reached within this round are only joined in the next round
+        _num_old_facts = std::move(_num_known_facts);
+        _num_known_facts.clear();
+        for (const auto& [predId, facts] : _reachable_by_predicate) _num_known_facts[predId] = facts.size();
+
+        for (const auto& [nameId, a] : _htn.getActionTemplates()) {
+            if (abortedActions.count(nameId)) continue;
+
+            // Only re-ground actions which may have new groundings
+            if (numRounds > 0) {
+                bool affected = false;
+                for (const Signature& pre : a.getPreconditions()) {
+                    if (!pre._negated && _last_changed_predicates.count(pre._usig._name_id)) {
+                        affected = true;
+                        break;
+                    }
+                }
+                if (!affected) continue;
+            }
+
+            if (!ground(a)) {
+                // Too many groundings: give up on this action's effects
+                Log::d("Relaxed reachability: too many groundings of %s\n", TOSTR(a.getSignature()));
+                abortedActions.insert(nameId);
+                for (const Signature& eff : a.getEffects()) {
+                    if (eff._negated) _unrestricted_deletable_predicates.insert(eff._usig._name_id);
+                    else if (_unrestricted_predicates.insert(eff._usig._name_id).second) {
+                        _changed_predicates.insert(eff._usig._name_id);
+                    }
+                }
+            }
+        }
+        numRounds++;
+    } while (!_changed_predicates.empty());
+    _computed = true;
+
+    Log::i("Relaxed reachability: %i reachable facts, %i unrestricted predicates after %i rounds (%.4fs)\n",
+        _reachable.size(), _unrestricted_predicates.size(), numRounds, Timer::elapsedSeconds() - time);
+}
+
+bool RelaxedReachability::ground(const Action& a) {
+
+    const std::vector<int>& args = a.getArguments();
+
+    // Collect the positive preconditions to join; check ground ones right away
+    std::vector<const USignature*> conds;
+    bool joinAll = false;
+    for (const Signature& pre : a.getPreconditions()) {
+        if (pre._negated) continue;
+        int predId = pre._usig._name_id;
+        if (_unrestricted_predicates.count(predId)) {
+            // Some groundings may have been ruled out by this condition before
+            joinAll |= _last_changed_predicates.count(predId);
+            continue;
+        }
+        bool isGround = true;
+        for (int arg : pre._usig._args) {
+            if (std::find(args.begin(), args.end(), arg) != args.end() || _htn.isVariable(arg)) isGround = false;
+        }
+        if (isGround) {
+            if (!_reachable.contains(_fact_index.getId(pre._usig), pre._usig)) return true;
+            joinAll |= _last_changed_predicates.count(predId);
+            continue;
+        }
+        conds.push_back(&pre._usig);
+    }
+
+    size_t numGroundings = 0;
+    if (joinAll || conds.empty()) return join(a, conds, -1, numGroundings);
+
+    // Semi-naive evaluation: each new grounding uses some fact of the last round
+    for (size_t i = 0; i < conds.size(); i++) {
+        if (!_last_changed_predicates.count(conds[i]->_name_id)) continue;
+        if (!join(a, conds, i, numGroundings)) return false;
+    }
+    return true;
+}
+
+bool RelaxedReachability::join(const Action& a, const std::vector<const USignature*>& conds,
+        int newCondIdx, size_t& numGroundings) {
+
+    const std::vector<int>& args = a.getArguments();
+    const std::vector<int>& sorts = _htn.getSorts(a.getNameId());
+
+    auto argIndex = [&](int arg) {
+        for (size_t i = 0; i < args.size(); i++) if (args[i] == arg) return (int)i;
+        return -1;
+    };
+
+    // Range of facts which each condition is joined with
+    std::vector<size_t> begins(conds.size()), ends(conds.size());
+    for (size_t k = 0; k < conds.size(); k++) {
+        bool onlyOld = newCondIdx >= 0 && (int)k < newCondIdx;
+        bool onlyNew = (int)k == newCondIdx;
+        getFactRange(conds[k]->_name_id, onlyOld, onlyNew, begins[k], ends[k]);
+        if (begins[k] == ends[k]) return true;
+    }
+
+    std::vector<std::vector<int>> bindings(1, std::vector<int>(args.size(), UNBOUND));
+    std::vector<bool> bound(args.size(), false);
+    std::vector<bool> joined(conds.size(), false);
+    std::vector<int> scratch(args.size());
+
+    for (size_t n = 0; n < conds.size(); n++) {
+
+        // Join the condition with the most bound arguments next, preferring few candidate facts
+        int best = -1;
+        int bestNumBound = -1;
+        size_t bestNumFacts = 0;
+        for (size_t k = 0; k < conds.size(); k++) {
+            if (joined[k]) continue;
+            int numBound = 0;
+            for (int arg : conds[k]->_args) {
+                int idx = argIndex(arg);
+                if (idx >= 0 && bound[idx]) numBound++;
+            }
+            size_t numFacts = ends[k] - begins[k];
+            if (numBound > bestNumBound || (numBound == bestNumBound && numFacts < bestNumFacts)) {
+                best = k;
+                bestNumBound = numBound;
+                bestNumFacts = numFacts;
+            }
+        }
+        joined[best] = true;
+        const USignature& cond = *conds[best];
+        const std::vector<USignature>& facts = _reachable_by_predicate.at(cond._name_id);
+
+        std::vector<int> condArgIndices(cond._args.size());
+        for (size_t j = 0; j < cond._args.size(); j++) condArgIndices[j] = argIndex(cond._args[j]);
+
+        std::vector<std::vector<int>> newBindings;
+        for (const auto& binding : bindings) for (size_t f = begins[best]; f < ends[best]; f++) {
+            const USignature& fact = facts[f];
+            if (fact._args.size() != cond._args.size()) continue;
+            scratch.assign(binding.begin(), binding.end());
+            bool consistent = true;
+            for (size_t j = 0; j < cond._args.size() && consistent; j++) {
+                int idx = condArgIndices[j];
+                int val = fact._args[j];
+                if (idx < 0) {
+                    // Constant or free variable
+                    consistent = _htn.isVariable(cond._args[j]) || cond._args[j] == val;
+                } else if (scratch[idx] == UNBOUND) {
+                    consistent = _htn.getConstantsOfSort(sorts[idx]).count(val);
+                    scratch[idx] = val;
+                } else {
+                    consistent = scratch[idx] == val;
+                }
+            }
+            if (!consistent) continue;
+            newBindings.push_back(scratch);
+            if (++numGroundings > MAX_GROUNDINGS_PER_ACTION) return false;
+        }
+        if (newBindings.empty()) return true;
+        bindings = std::move(newBindings);
+        for (int idx : condArgIndices) if (idx >= 0) bound[idx] = true;
+    }
+
+    // Instantiate the effects of each grounding
+    std::vector<std::vector<int>> domains(args.size());
+    for (const auto& binding : bindings) {
+        if (!addEffects(a, binding, domains, numGroundings)) return false;
+    }
+    return true;
+}
+
+void RelaxedReachability::getFactRange(int predId, bool onlyOld, bool onlyNew, size_t& begin, size_t& end) const {
+    auto numOld = _num_old_facts.find(predId);
+    auto numKnown = _num_known_facts.find(predId);
+    begin = onlyNew && numOld != _num_old_facts.end() ? numOld->second : 0;
+    if (onlyOld) end = numOld == _num_old_facts.end() ? 0 : numOld->second;
+    else end = numKnown == _num_known_facts.end() ? 0 : numKnown->second;
+}
+
+bool RelaxedReachability::addEffects(const Action& a, const std::vector<int>& binding,
+        std::vector<std::vector<int>>& domains, size_t& numGroundings) {
+
+    const std::vector<int>& args = a.getArguments();
+    const std::vector<int>& sorts = _htn.getSorts(a.getNameId());
+
+    for (const Signature& eff : a.getEffects()) {
+
+        // Bind the effect's arguments; remember unbound action arguments
+        std::vector<int> factArgs(eff._usig._args.size());
+        std::vector<int> unboundIndices;
+        std::vector<int> positionIndices(eff._usig._args.size(), -1);
+        bool unrestricted = false;
+        for (size_t j = 0; j < factArgs.size(); j++) {
+            int arg = eff._usig._args[j];
+            int idx = -1;
+            for (size_t i = 0; i < args.size(); i++) if (args[i] == arg) idx = i;
+            if (idx < 0) {
+                factArgs[j] = arg;
+                if (_htn.isVariable(arg)) unrestricted = true;
+            } else if (binding[idx] == UNBOUND) {
+                positionIndices[j] = idx;
+                if (std::find(unboundIndices.begin(), unboundIndices.end(), idx) == unboundIndices.end())
+                    unboundIndices.push_back(idx);
+            } else {
+                factArgs[j] = binding[idx];
+            }
+        }
+
+        if (unrestricted) {
+            // Effect over some variable which is no argument of the action
+            if (eff._negated) _unrestricted_deletable_predicates.insert(eff._usig._name_id);
+            else if (_unrestricted_predicates.insert(eff._usig._name_id).second) {
+                _changed_predicates.insert(eff._usig._name_id);
+            }
+            continue;
+        }
+
+        // Enumerate all values of the unbound arguments within their sorts
+        for (int idx : unboundIndices) if (domains[idx].empty()) {
+            for (int c : _htn.getConstantsOfSort(sorts[idx])) {
+                if (!_htn.isQConstant(c)) domains[idx].push_back(c);
+            }
+            if (domains[idx].empty()) return true;
+        }
+        std::vector<size_t> counters(unboundIndices.size(), 0);
+        while (true) {
+            USignature fact(eff._usig._name_id, factArgs);
+            for (size_t j = 0; j < factArgs.size(); j++) {
+                if (positionIndices[j] < 0) continue;
+                size_t k = std::find(unboundIndices.begin(), unboundIndices.end(), positionIndices[j]) - unboundIndices.begin();
+                fact._args[j] = domains[positionIndices[j]][counters[k]];
+            }
+            if (eff._negated) addDeletable(fact);
+            else addReachable(fact);
+
+            if (++numGroundings > MAX_GROUNDINGS_PER_ACTION) return false;
+
+            // Next assignment
+            size_t k = 0;
+            while (k < counters.size() && ++counters[k] == domains[unboundIndices[k]].size()) {
+                counters[k++] = 0;
+            }
+            if (k == counters.size()) break;
+        }
+    }
+    return true;
+}
+
+void RelaxedReachability::addReachable(const USignature& fact) {
+    if (_unrestricted_predicates.count(fact._name_id)) return;
+    long id = _fact_index.getId(fact);
+    if (_reachable.contains(id, fact)) return;
+    _reachable.insert(id, fact);
+    _reachable_by_predicate[fact._name_id].push_back(fact);
+    _changed_predicates.insert(fact._name_id);
+}
+
+void RelaxedReachability::addDeletable(const USignature& fact) {
+    _deletable.insert(_fact_index.getId(fact), fact);
+}
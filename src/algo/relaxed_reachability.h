@@ -0,0 +1,87 @@
+
+#ifndef DOMPASCH_LILOTANE_RELAXED_REACHABILITY_H
+#define DOMPASCH_LILOTANE_RELAXED_REACHABILITY_H
+
+#include <vector>
+
+#include "util/hashmap.h"
+#include "data/signature.h"
+#include "data/htn_instance.h"
+#include "data/fact_index.h"
+
+/*
+Static over-approximation of the reachable ground facts under the delete relaxation:
+Starting from the initial state, all action templates are repeatedly grounded
+over the facts reached so far (ignoring negative preconditions and the hierarchy)
+until a fixpoint is reached. Each action is grounded by joining its positive
+preconditions one at a time. After the first round, only groundings which use
+some fact reached in the previous round are computed (semi-naive evaluation):
+for the i-th condition ranging over the new facts, the conditions before it range
+over the older facts only. If the groundings of an action exceed a limit,
+all predicates of its effects are conservatively considered unrestricted.
+Besides the reachable facts, the facts which some reachable action deletes are collected.
+*/
+class RelaxedReachability {
+
+private:
+    HtnInstance& _htn;
+    const FactIndex& _fact_index;
+
+    FactSet _reachable;
+    FactSet _deletable;
+    NodeHashMap<int, std::vector<USignature>> _reachable_by_predicate;
+
+    // Per predicate: number of facts in _reachable_by_predicate which were reached
+    // before the last round / before the current round.
+    FlatHashMap<int, size_t> _num_old_facts;
+    FlatHashMap<int, size_t> _num_known_facts;
+
+    // Predicates for which any ground fact is considered reachable / deletable.
+    FlatHashSet<int> _unrestricted_predicates;
+    FlatHashSet<int> _unrestricted_deletable_predicates;
+
+    // Predicates which gained some reachable fact in the current / last round.
+    FlatHashSet<int> _changed_predicates;
+    FlatHashSet<int> _last_changed_predicates;
+
+    bool _computed = false;
+
+public:
+    // Max. number of (partial) groundings of a single action in a single round.
+    static const size_t MAX_GROUNDINGS_PER_ACTION = 1000000;
+
+    RelaxedReachability(HtnInstance& htn, const FactIndex& index) : _htn(htn), _fact_index(index),
+            _reachable(index), _deletable(index) {}
+
+    void compute(const USigSet& initState);
+
+    // Without a computed fixpoint, all facts are considered reachable and deletable.
+    inline bool isReachable(const USignature& fact, long id) const {
+        return !_computed || _unrestricted_predicates.count(fact._name_id) || _reachable.contains(id, fact);
+    }
+    inline bool isDeletable(const USignature& fact, long id) const {
+        return !_computed || _unrestricted_deletable_predicates.count(fact._name_id) || _deletable.contains(id, fact);
+    }
+
+    // Same for an indexed fact (id >= 0) of the given predicate.
+    inline bool isReachable(int predId, long id) const {
+        return !_computed || _unrestricted_predicates.count(predId) || _reachable.contains(id);
+    }
+    inline bool isDeletable(int predId, long id) const {
+        return !_computed || _unrestricted_deletable_predicates.count(predId) || _deletable.contains(id);
+    }
+
+    bool isComputed() const {
+        return _computed;
+    }
+
+private:
+    bool ground(const Action& a);
+    bool join(const Action& a, const std::vector<const USignature*>& conds, int newCondIdx, size_t& numGroundings);
+    void getFactRange(int predId, bool onlyOld, bool onlyNew, size_t& begin, size_t& end) const;
+    bool addEffects(const Action& a, const std::vector<int>& binding, std::vector<std::vector<int>>& domains, size_t& numGroundings);
+    void addReachable(const USignature& fact);
+    void addDeletable(const USignature& fact);
+};
+
+#endif
@@ -30,17 +30,17 @@ void RetroactivePruning::prune(const USignature& op, int layerIdx, int pos) {
             oldPos++;
 
         bool pruneSomeParent = false;
-        assert(position.getPredecessors().count(psig.usig) || Log::e("%s has no predecessors!\n", TOSTR(psig)));
-        for (const auto& parent : position.getPredecessors().at(psig.usig)) {
+        assert(position.hasPredecessorsOf(psig.usig) || Log::e("%s has no predecessors!\n", TOSTR(psig)));
+        for (const auto& parent : position.getPredecessorsOf(psig.usig)) {
             PositionedUSig parentPSig(psig.layer-1, oldPos, parent);
             //assert(oldLayer.at(oldPos).hasAction(parent) || oldLayer.at(oldPos).hasReduction(parent) || Log::e("%s\n", TOSTR(parentPSig)));
-            const auto& siblings = position.getExpansions().at(parent);
+            size_t numSiblings = position.getNumExpansionsOf(parent);
 
             // Mark op for removal from expansion of the parent
-            assert(siblings.count(psig.usig));
+            assert(position.hasExpansion(parent, psig.usig));
             removedExpansionsOfParents[parentPSig].insert(psig.usig);
 
-            if (removedExpansionsOfParents[parentPSig].size() == siblings.size()) {
+            if (removedExpansionsOfParents[parentPSig].size() == numSiblings) {
                 // Siblings become empty -> prune parent as well
                 openOps.insert(std::move(parentPSig));
                 pruneSomeParent = true;
@@ -66,17 +66,17 @@ void RetroactivePruning::prune(const USignature& op, int layerIdx, int pos) {
             while (belowPosIdx < (int)_layers.at(psig.layer)->getSuccessorPos(psig.pos+1)) {
 
                 Position& below = _layers.at(psig.layer+1)->at(belowPosIdx);
-                if (below.getExpansions().count(psig.usig)) for (auto& child : below.getExpansions().at(psig.usig)) {
-                    assert(below.getPredecessors().at(child).count(psig.usig));
+                if (below.hasExpansionsOf(psig.usig)) for (const auto& child : below.getExpansionsOf(psig.usig)) {
+                    assert(below.hasExpansion(psig.usig, child));
                     if (psig.layer+1 == (size_t)layerIdx && belowPosIdx == pos && child == op) {
                         // Arrived back at original op to prune
                         opsToRemove.emplace(layerIdx, pos, op);
-                    } else if (below.getPredecessors().at(child).size() == 1) {
+                    } else if (below.getNumPredecessorsOf(child) == 1) {
                         // Child has this op as its only predecessor -> prune
                         opsToRemove.emplace(psig.layer+1, belowPosIdx, child);
                     } else {
-                        Log::d("PRUNE %i pred left for %s@(%i,%i): %s\n", below.getPredecessors().at(child).size()-1, TOSTR(child), psig.layer+1, belowPosIdx);
-                        below.getPredecessors().at(child).erase(psig.usig);
+                        Log::d("PRUNE %i pred left for %s@(%i,%i): %s\n", below.getNumPredecessorsOf(child)-1, TOSTR(child), psig.layer+1, belowPosIdx);
+                        below.removePredecessor(child, psig.usig);
                     }
                 } else Log::d("PRUNE No expansions for %s @ (%i,%i)\n", TOSTR(psig), psig.layer+1, belowPosIdx);
 
@@ -8,6 +8,7 @@
 #include "data/signature.h"
 #include "util/log.h"
 #include "util/random.h"
+#include "algo/arg_iterator.h"
 
 class HtnInstance;
 
@@ -15,7 +16,7 @@ class SampleArgIterator {
 
 private:
 
-    std::vector<std::vector<int>> _eligible_args;
+    EligibleArgs _eligible_args;
     size_t _num_samples;
 
     struct It {
@@ -67,6 +68,7 @@ private:
                 randomIdx -= idx * factor;
             }
             assert(factor == 1);
+            _usig.invalidateHash();
         }
 
     } _begin, _end;
@@ -74,12 +76,13 @@ private:
 public:
 
     SampleArgIterator(int sigId, std::vector<std::vector<int>>&& eligibleArgs, size_t numSamples) : 
-            _eligible_args(std::move(eligibleArgs)), _num_samples(numSamples),
-            _begin(sigId, _eligible_args, _num_samples),
-            _end(sigId, _eligible_args, _num_samples) {
+            SampleArgIterator(sigId, std::make_shared<const std::vector<std::vector<int>>>(std::move(eligibleArgs)), numSamples) {}
+
+    SampleArgIterator(int sigId, const EligibleArgs& eligibleArgs, size_t numSamples) : 
+            _eligible_args(eligibleArgs), _num_samples(numSamples),
+            _begin(sigId, *_eligible_args, _num_samples),
+            _end(sigId, *_eligible_args, _num_samples) {
         
-        size_t numChoices = _eligible_args.empty() ? 0 : 1;
-        for (const auto& args : _eligible_args) numChoices *= args.size();
         _end._num_samples = 0;
     }
 
@@ -0,0 +1,67 @@
+
+#ifndef DOMPASCH_LILOTANE_CONSTANT_BITSET_H
+#define DOMPASCH_LILOTANE_CONSTANT_BITSET_H
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+/*
+A set of constants, represented as a bitset over dense constant indices
+(see HtnInstance). Set operations work word by word, which compilers
+turn into vectorized AND / OR / popcount loops.
+*/
+class ConstantBitset {
+
+private:
+    std::vector<uint64_t> _words;
+
+public:
+    ConstantBitset() = default;
+    ConstantBitset(size_t numBits) : _words((numBits+63) / 64, 0) {}
+
+    inline void set(size_t idx) {
+        if (idx/64 >= _words.size()) _words.resize(idx/64 + 1, 0);
+        _words[idx/64] |= (uint64_t)1 << (idx % 64);
+    }
+
+    inline bool test(size_t idx) const {
+        return idx/64 < _words.size() && (_words[idx/64] >> (idx % 64)) & 1;
+    }
+
+    inline void unite(const ConstantBitset& other) {
+        if (other._words.size() > _words.size()) _words.resize(other._words.size(), 0);
+        for (size_t i = 0; i < other._words.size(); i++) _words[i] |= other._words[i];
+    }
+
+    // Whether this set and the other set have some element in common.
+    inline bool intersects(const ConstantBitset& other) const {
+        size_t n = std::min(_words.size(), other._words.size());
+        for (size_t i = 0; i < n; i++) if (_words[i] & other._words[i]) return true;
+        return false;
+    }
+
+    // Whether each element of this set is contained in the other set.
+    inline bool isSubsetOf(const ConstantBitset& other) const {
+        for (size_t i = 0; i < _words.size(); i++) {
+            uint64_t otherWord = i < other._words.size() ? other._words[i] : 0;
+            if (_words[i] & ~otherWord) return false;
+        }
+        return true;
+    }
+
+    inline size_t count() const {
+        size_t c = 0;
+        for (uint64_t w : _words) c += __builtin_popcountll(w);
+        return c;
+    }
+
+    inline size_t countIntersection(const ConstantBitset& other) const {
+        size_t n = std::min(_words.size(), other._words.size());
+        size_t c = 0;
+        for (size_t i = 0; i < n; i++) c += __builtin_popcountll(_words[i] & other._words[i]);
+        return c;
+    }
+};
+
+#endif
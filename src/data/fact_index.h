@@ -0,0 +1,197 @@
+
+#ifndef DOMPASCH_LILOTANE_FACT_INDEX_H
+#define DOMPASCH_LILOTANE_FACT_INDEX_H
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+#include "util/hashmap.h"
+#include "data/signature.h"
+#include "data/htn_instance.h"
+
+/*
+Assigns a dense ID to each ground fact whose arguments lie within the sorts
+of its predicate. The facts of a predicate with argument sorts (S_1, ..., S_k)
+occupy a contiguous range of IDs, and a fact is mapped into this range by a
+mixed-radix number over the positions of its arguments within S_1, ..., S_k.
+Predicates whose range would exceed the overall capacity are not indexed.
+*/
+class FactIndex {
+
+private:
+    struct PredicateInfo {
+        bool indexed = false;
+        size_t offset = 0;
+        // Per argument position: index into _local_ids_per_sort and radix.
+        std::vector<int> sortIdx;
+        std::vector<size_t> radices;
+    };
+
+    // Predicate name ID -> indexing information.
+    std::vector<PredicateInfo> _predicates;
+    // Constant name ID -> dense constant index (or -1).
+    std::vector<int> _dense_constants;
+    // For each involved sort: dense constant index -> position within sort (or -1).
+    std::vector<std::vector<int>> _local_ids_per_sort;
+
+    int _num_dense_constants = 0;
+    size_t _size = 0;
+
+public:
+    // Max. number of fact IDs (= bits per fact set).
+    static const size_t MAX_SIZE = 1UL << 25;
+
+    FactIndex(HtnInstance& htn) {
+
+        FlatHashMap<int, int> sortIndices;
+        std::vector<std::pair<size_t, int>> predsBySize;
+
+        int maxPredId = 0;
+        for (int predId : htn.getPredicateIds()) maxPredId = std::max(maxPredId, predId);
+        _predicates.resize(maxPredId+1);
+
+        for (int predId : htn.getPredicateIds()) {
+            size_t size = 1;
+            for (int sort : htn.getSorts(predId)) {
+                size_t domainSize = htn.getConstantsOfSort(sort).size();
+                size = domainSize == 0 || size > MAX_SIZE ? 0 : size * domainSize;
+                if (size == 0) break;
+            }
+            if (size == 0 || size > MAX_SIZE) continue;
+            predsBySize.emplace_back(size, predId);
+        }
+
+        // Index the smallest predicates first
+        std::sort(predsBySize.begin(), predsBySize.end());
+        for (const auto& [size, predId] : predsBySize) {
+            if (_size + size > MAX_SIZE) break;
+            PredicateInfo& info = _predicates[predId];
+            info.indexed = true;
+            info.offset = _size;
+            const auto& sorts = htn.getSorts(predId);
+            info.sortIdx.resize(sorts.size());
+            info.radices.resize(sorts.size());
+            size_t radix = 1;
+            for (int i = sorts.size()-1; i >= 0; i--) {
+                auto it = sortIndices.find(sorts[i]);
+                if (it == sortIndices.end()) {
+                    it = sortIndices.emplace(sorts[i], addSort(htn.getConstantsOfSort(sorts[i]), htn)).first;
+                }
+                info.sortIdx[i] = it->second;
+                info.radices[i] = radix;
+                radix *= htn.getConstantsOfSort(sorts[i]).size();
+            }
+            _size += size;
+        }
+    }
+
+    // Returns the ID of the given fact, or -1 if the fact is not indexed.
+    inline long getId(const USignature& fact) const {
+        if (fact._name_id < 0 || (size_t)fact._name_id >= _predicates.size()) return -1;
+        const PredicateInfo& info = _predicates[fact._name_id];
+        if (!info.indexed || info.sortIdx.size() != fact._args.size()) return -1;
+        size_t id = info.offset;
+        for (size_t i = 0; i < fact._args.size(); i++) {
+            int arg = fact._args[i];
+            if (arg < 0 || (size_t)arg >= _dense_constants.size()) return -1;
+            int dense = _dense_constants[arg];
+            if (dense < 0) return -1;
+            int local = _local_ids_per_sort[info.sortIdx[i]][dense];
+            if (local < 0) return -1;
+            id += local * info.radices[i];
+        }
+        return id;
+    }
+
+    // Computes the ID offset of the given predicate and, for each argument position,
+    // the ID contribution of each of the given constants: the ID of a fact is the offset
+    // plus the contributions of its arguments. Returns false if not all of these facts are indexed.
+    bool getProjections(int predId, const std::vector<std::vector<int>>& argDomains, 
+            size_t& offset, std::vector<std::vector<size_t>>& projections) const {
+        if (predId < 0 || (size_t)predId >= _predicates.size()) return false;
+        const PredicateInfo& info = _predicates[predId];
+        if (!info.indexed || info.sortIdx.size() != argDomains.size()) return false;
+        offset = info.offset;
+        projections.resize(argDomains.size());
+        for (size_t i = 0; i < argDomains.size(); i++) {
+            projections[i].resize(argDomains[i].size());
+            for (size_t j = 0; j < argDomains[i].size(); j++) {
+                int arg = argDomains[i][j];
+                if (arg < 0 || (size_t)arg >= _dense_constants.size()) return false;
+                int dense = _dense_constants[arg];
+                if (dense < 0) return false;
+                int local = _local_ids_per_sort[info.sortIdx[i]][dense];
+                if (local < 0) return false;
+                projections[i][j] = local * info.radices[i];
+            }
+        }
+        return true;
+    }
+
+    size_t size() const {
+        return _size;
+    }
+
+private:
+    // Registers the given sort and returns its index.
+    int addSort(const FlatHashSet<int>& constants, HtnInstance& htn) {
+        // Assign dense indices to new constants
+        for (int c : constants) {
+            if (c < 0 || htn.isQConstant(c)) continue;
+            if ((size_t)c >= _dense_constants.size()) _dense_constants.resize(c+1, -1);
+            if (_dense_constants[c] < 0) _dense_constants[c] = _num_dense_constants++;
+        }
+        for (auto& ids : _local_ids_per_sort) ids.resize(_num_dense_constants, -1);
+
+        std::vector<int> localIds(_num_dense_constants, -1);
+        int local = 0;
+        for (int c : constants) {
+            if (c < 0 || htn.isQConstant(c)) continue;
+            localIds[_dense_constants[c]] = local++;
+        }
+        _local_ids_per_sort.push_back(std::move(localIds));
+        return _local_ids_per_sort.size()-1;
+    }
+};
+
+/*
+Set of ground facts: Indexed facts are kept in a bitset over their fact IDs,
+all other facts in a hash set. Copying a set is a plain copy of its words.
+*/
+class FactSet {
+
+private:
+    std::vector<uint64_t> _words;
+    USigSet _others;
+
+public:
+    FactSet() = default;
+    FactSet(const FactIndex& index) : _words((index.size()+63) / 64, 0) {}
+
+    inline void insert(long id, const USignature& fact) {
+        if (id < 0) _others.insert(fact);
+        else _words[id/64] |= (uint64_t)1 << (id % 64);
+    }
+    inline bool contains(long id, const USignature& fact) const {
+        if (id < 0) return _others.count(fact);
+        return contains(id);
+    }
+    // Only for indexed facts (id >= 0).
+    inline bool contains(long id) const {
+        return (_words[id/64] >> (id % 64)) & 1;
+    }
+
+    void clear() {
+        std::fill(_words.begin(), _words.end(), 0);
+        _others.clear();
+    }
+
+    size_t size() const {
+        size_t size = _others.size();
+        for (uint64_t w : _words) size += __builtin_popcountll(w);
+        return size;
+    }
+};
+
+#endif
@@ -0,0 +1,185 @@
+
+#ifndef DOMPASCH_LILOTANE_FROZEN_EXPANSIONS_H
+#define DOMPASCH_LILOTANE_FROZEN_EXPANSIONS_H
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+#include "util/hashmap.h"
+#include "data/signature.h"
+
+/*
+Compact, read-mostly representation of the expansions and predecessors
+of a position which has been fully instantiated and encoded.
+All occurring operations are interned into a vector sorted by hash value,
+and both relations are stored as compressed sparse rows over the op indices.
+Entries can still be removed (as retroactive pruning requires) by swapping
+them to the end of their row and shrinking the row.
+*/
+class FrozenExpansions {
+
+private:
+    // Interned operations, sorted by their hash value.
+    std::vector<USignature> _ops;
+
+    // Children of each op: _exp_targets[_exp_offsets[i] .. _exp_offsets[i]+_exp_sizes[i]).
+    std::vector<uint32_t> _exp_offsets;
+    std::vector<uint32_t> _exp_sizes;
+    std::vector<uint32_t> _exp_targets;
+
+    // Parents of each op: _pred_targets[_pred_offsets[i] .. _pred_offsets[i]+_pred_sizes[i]).
+    std::vector<uint32_t> _pred_offsets;
+    std::vector<uint32_t> _pred_sizes;
+    std::vector<uint32_t> _pred_targets;
+
+    // Whether some predecessors entry exists for each op.
+    std::vector<bool> _has_pred_entry;
+    // Whether some expansions entry exists for each op.
+    std::vector<bool> _has_exp_entry;
+
+public:
+    FrozenExpansions(const NodeHashMap<USignature, USigSet, USignatureHasher>& expansions,
+            const NodeHashMap<USignature, USigSet, USignatureHasher>& predecessors) {
+
+        // Intern all occurring operations
+        USigSet ops;
+        for (const auto& [parent, children] : expansions) {
+            ops.insert(parent);
+            for (const auto& child : children) ops.insert(child);
+        }
+        for (const auto& [child, parents] : predecessors) {
+            ops.insert(child);
+            for (const auto& parent : parents) ops.insert(parent);
+        }
+        _ops.reserve(ops.size());
+        for (const auto& op : ops) _ops.push_back(op);
+        std::sort(_ops.begin(), _ops.end(), [](const USignature& a, const USignature& b) {
+            return a.getHash() < b.getHash();
+        });
+
+        buildRows(expansions, _exp_offsets, _exp_sizes, _exp_targets, _has_exp_entry);
+        buildRows(predecessors, _pred_offsets, _pred_sizes, _pred_targets, _has_pred_entry);
+    }
+
+    // Returns the internal index of the given op, or -1 if it does not occur.
+    int getIndex(const USignature& sig) const {
+        size_t hash = sig.getHash();
+        auto it = std::lower_bound(_ops.begin(), _ops.end(), hash, [](const USignature& op, size_t h) {
+            return op.getHash() < h;
+        });
+        while (it != _ops.end() && it->getHash() == hash) {
+            if (*it == sig) return it - _ops.begin();
+            ++it;
+        }
+        return -1;
+    }
+
+    const USignature& getOp(int idx) const {
+        return _ops[idx];
+    }
+
+    bool hasExpansions(const USignature& parent) const {
+        int idx = getIndex(parent);
+        return idx >= 0 && _has_exp_entry[idx];
+    }
+    bool hasPredecessors(const USignature& child) const {
+        int idx = getIndex(child);
+        return idx >= 0 && _has_pred_entry[idx];
+    }
+
+    std::vector<USignature> getExpansions(const USignature& parent) const {
+        return getRow(getIndex(parent), _exp_offsets, _exp_sizes, _exp_targets);
+    }
+    std::vector<USignature> getPredecessors(const USignature& child) const {
+        return getRow(getIndex(child), _pred_offsets, _pred_sizes, _pred_targets);
+    }
+
+    size_t getNumExpansions(const USignature& parent) const {
+        int idx = getIndex(parent);
+        return idx < 0 ? 0 : _exp_sizes[idx];
+    }
+    size_t getNumPredecessors(const USignature& child) const {
+        int idx = getIndex(child);
+        return idx < 0 ? 0 : _pred_sizes[idx];
+    }
+
+    bool hasExpansion(const USignature& parent, const USignature& child) const {
+        int p = getIndex(parent);
+        int c = getIndex(child);
+        if (p < 0 || c < 0) return false;
+        const uint32_t* begin = _exp_targets.data() + _exp_offsets[p];
+        return std::find(begin, begin + _exp_sizes[p], (uint32_t)c) != begin + _exp_sizes[p];
+    }
+
+    // Removes the given parent from the predecessors of the given child.
+    // As in Position, the expansions of the parent are left untouched.
+    void removePredecessor(const USignature& child, const USignature& parent) {
+        int c = getIndex(child);
+        int p = getIndex(parent);
+        if (c < 0 || p < 0) return;
+        removeFromRow(c, p, _pred_offsets, _pred_sizes, _pred_targets);
+    }
+
+    // Removes the given op as a child of all of its parents and drops its predecessors.
+    void removeOccurrence(const USignature& op) {
+        int c = getIndex(op);
+        if (c < 0) return;
+        for (uint32_t i = _pred_offsets[c]; i < _pred_offsets[c] + _pred_sizes[c]; i++) {
+            removeFromRow(_pred_targets[i], c, _exp_offsets, _exp_sizes, _exp_targets);
+        }
+        _pred_sizes[c] = 0;
+        _has_pred_entry[c] = false;
+    }
+
+private:
+    void buildRows(const NodeHashMap<USignature, USigSet, USignatureHasher>& map,
+            std::vector<uint32_t>& offsets, std::vector<uint32_t>& sizes,
+            std::vector<uint32_t>& targets, std::vector<bool>& hasEntry) {
+
+        sizes.assign(_ops.size(), 0);
+        hasEntry.assign(_ops.size(), false);
+        for (const auto& [key, values] : map) {
+            int idx = getIndex(key);
+            sizes[idx] = values.size();
+            hasEntry[idx] = true;
+        }
+        offsets.resize(_ops.size());
+        uint32_t offset = 0;
+        for (size_t i = 0; i < _ops.size(); i++) {
+            offsets[i] = offset;
+            offset += sizes[i];
+        }
+        targets.resize(offset);
+        for (const auto& [key, values] : map) {
+            uint32_t pos = offsets[getIndex(key)];
+            for (const auto& value : values) targets[pos++] = getIndex(value);
+        }
+    }
+
+    std::vector<USignature> getRow(int idx, const std::vector<uint32_t>& offsets,
+            const std::vector<uint32_t>& sizes, const std::vector<uint32_t>& targets) const {
+        std::vector<USignature> result;
+        if (idx < 0) return result;
+        result.reserve(sizes[idx]);
+        for (uint32_t i = offsets[idx]; i < offsets[idx] + sizes[idx]; i++) {
+            result.push_back(_ops[targets[i]]);
+        }
+        return result;
+    }
+
+    void removeFromRow(uint32_t row, uint32_t value, const std::vector<uint32_t>& offsets,
+            std::vector<uint32_t>& sizes, std::vector<uint32_t>& targets) {
+        uint32_t begin = offsets[row];
+        uint32_t end = begin + sizes[row];
+        for (uint32_t i = begin; i < end; i++) {
+            if (targets[i] == value) {
+                targets[i] = targets[end-1];
+                sizes[row]--;
+                return;
+            }
+        }
+    }
+};
+
+#endif
@@ -6,21 +6,42 @@
 
 #include "data/htn_instance.h"
 #include "util/regex.h"
+#include "util/snapshot_io.h"
+#include "algo/decomposition_graph.h"
 
 #include "libpanda.hpp"
 
 Action HtnInstance::BLANK_ACTION;
 
+// Max. number of memoized argument domains before the memo is reset.
+const size_t MAX_ELIGIBLE_ARGS_CACHE_SIZE = 100000;
+
 HtnInstance::HtnInstance(Parameters& params) :
-             _params(params), _p(*parse(params.getDomainFilename(), params.getProblemFilename())), 
-            _share_q_constants(_params.isNonzero("sqq")) {
+             _params(params), 
+            // If loading from a snapshot, the parser is only run to convert the final plan
+            _p(params.isSet("snapshot-in") && params.getProblemFilename() == "" ? nullptr 
+                : parse(params.getDomainFilename(), params.getProblemFilename())), 
+            _from_snapshot(params.isSet("snapshot-in")), 
+            _op_table(_operators, _methods), _share_q_constants(_params.isNonzero("sqq")) {
 
     // Transfer random seed to the hash function for any kind of signature
     USignatureHasher::seed = _params.getIntParam("s");
 
-    Log::i("Parser finished.\n");
+    _op_table.setMaxCacheSize(_params.getIntParam("otc"));
+
+    Names::init(_name_back_table, _q_constants);
+
+    if (_from_snapshot) {
+        // Skip extraction and preprocessing
+        readSnapshot(_params.getParam("snapshot-in"));
+        if (_params.isNonzero("stats")) {
+            printStatistics();
+            exit(0);
+        }
+        return;
+    }
 
-    Names::init(_name_back_table);
+    Log::i("Parser finished.\n");
     
     // Create blank action without any preconditions or effects
     int blankId = nameId("__BLANK___");
@@ -42,7 +63,7 @@ HtnInstance::HtnInstance(Parameters& params) :
     extractConstants();
 
     Log::i("Structures extracted.\n");
-    for (const auto& sort_pair : _p.sorts) {
+    for (const auto& sort_pair : _p->sorts) {
         Log::d(" %s : ", sort_pair.first.c_str());
         for (const std::string& c : sort_pair.second) {
             Log::d("%s ", c.c_str());
@@ -60,6 +81,8 @@ HtnInstance::HtnInstance(Parameters& params) :
         createReduction(method);
     }
 
+    extractInitFactsAndGoals();
+
     if (_params.isNonzero("stats")) {
         printStatistics();
         exit(0);
@@ -220,19 +243,13 @@ void HtnInstance::primitivizeSimpleReductions() {
     }
 }
 
-int HtnInstance::nameId(const std::string& name, bool createQConstant, int layerIdx, int pos) {
+int HtnInstance::nameId(const std::string& name) {
     int id = -1;
     if (!_name_table.count(name)) {
-        if (createQConstant) {
-            id = std::numeric_limits<int>::max() - _q_constants_with_origin.size();
-            assert(layerIdx >= 0 && pos >= 0);
-            _q_constants_with_origin[id] = IntPair(layerIdx, pos);
-        } else {
-            id = _name_table_running_id++;
-            if (name[0] == '?') {
-                // variable
-                _var_ids.insert(id);
-            }
+        id = _name_table_running_id++;
+        if (name[0] == '?') {
+            // variable
+            _var_ids.insert(id);
         }
         _name_table[name] = id;
         _name_back_table[id] = name;
@@ -241,6 +258,8 @@ int HtnInstance::nameId(const std::string& name, bool createQConstant, int layer
 }
 
 std::string HtnInstance::toString(int id) const {
+    if (_q_constants.isQConstant(id)) return _q_constants.getName(id, _name_back_table);
+    if (_q_constants.isQSort(id)) return _q_constants.getQSortName(id, _name_back_table);
     return _name_back_table.at(id);
 }
 
@@ -273,11 +292,15 @@ Signature HtnInstance::convertSignature(int parentNameId, const literal& literal
     return sig;
 }
 
-USigSet HtnInstance::getInitState() {
-    USigSet result;
-    for (const ground_literal& lit : _p.init) if (lit.positive) {
-        result.emplace(nameId(lit.predicate), convertArguments(nameId(lit.predicate), lit.args));
+void HtnInstance::extractInitFactsAndGoals() {
+    for (const ground_literal& lit : _p->init) if (lit.positive) {
+        _init_facts.emplace_back(nameId(lit.predicate), convertArguments(nameId(lit.predicate), lit.args));
     }
+    _goal_facts = extractGoals();
+}
+
+USigSet HtnInstance::getInitState() {
+    USigSet result(_init_facts.begin(), _init_facts.end());
 
     // Insert all necessary equality predicates
 
@@ -305,7 +328,7 @@ USigSet HtnInstance::getInitState() {
 
 SigSet HtnInstance::extractGoals() {
     SigSet result;
-    for (const ground_literal& lit : _p.goal) {
+    for (const ground_literal& lit : _p->goal) {
         Signature sig(nameId(lit.predicate), convertArguments(nameId(lit.predicate), lit.args));
         if (!lit.positive) sig.negate();
         result.insert(sig);
@@ -319,9 +342,9 @@ Action HtnInstance::getGoalAction() {
     Action goalAction(nameId("<goal_action>"), std::vector<int>());
     USignature goalSig = goalAction.getSignature();
     
-    // Extract primitive goals, add to preconds of goal action
-    for (Signature& fact : extractGoals()) {
-        goalAction.addPrecondition(std::move(fact));
+    // Add primitive goals to preconds of goal action
+    for (const Signature& fact : _goal_facts) {
+        goalAction.addPrecondition(fact);
     }
     _op_table.addAction(goalAction);
     _operators[goalSig._name_id] = goalAction;
@@ -381,15 +404,33 @@ void HtnInstance::extractMethodSorts(const method& m) {
 }
 
 void HtnInstance::extractConstants() {
-    for (const auto& sortPair : _p.sorts) {
+    for (const auto& sortPair : _p->sorts) {
         int sortId = nameId(sortPair.first);
+        _sorts.push_back(sortId);
         _constants_by_sort[sortId];
         FlatHashSet<int>& constants = _constants_by_sort[sortId];
         for (const std::string& c : sortPair.second) {
-            constants.insert(nameId(c));
+            int cId = nameId(c);
+            constants.insert(cId);
+            if (!_dense_constant_ids.count(cId)) {
+                int denseId = _dense_constant_ids.size();
+                _dense_constant_ids[cId] = denseId;
+            }
             //log("constant %s of sort %s\n", c.c_str(), sortPair.first.c_str());
         }
     }
+    for (int sortId : _sorts) {
+        _constant_bitsets_by_sort[sortId] = toConstantBitset(_constants_by_sort[sortId]);
+    }
+}
+
+ConstantBitset HtnInstance::toConstantBitset(const FlatHashSet<int>& constants) const {
+    ConstantBitset bitset(_dense_constant_ids.size());
+    for (int c : constants) {
+        auto it = _dense_constant_ids.find(c);
+        if (it != _dense_constant_ids.end()) bitset.set(it->second);
+    }
+    return bitset;
 }
 
 Reduction& HtnInstance::createReduction(method& method) {
@@ -715,7 +756,7 @@ std::vector<int> HtnInstance::replaceVariablesWithQConstants(const HtnOp& op,
         } else {
             // Several valid constants here: Introduce q-constant
 
-            // Assemble name
+            // Determine the properties identifying the q-constant
             int sortCounter = 0;
             int primarySort = _signature_sorts_table[op.getSignature()._name_id][i];
             auto it = numIntroducedQConstsPerType.find(primarySort);
@@ -726,16 +767,10 @@ std::vector<int> HtnInstance::replaceVariablesWithQConstants(const HtnOp& op,
                 it->second++;
             }
             std::vector<int> domainVec(domain.begin(), domain.end());
-            std::stringstream domainHash;
-            domainHash << std::hex << USignatureHasher()(USignature(primarySort, domainVec));
-            std::string qConstName = "Q_" + std::to_string(layerIdx) + "," 
-                + std::to_string(pos) + "_" + _name_back_table[primarySort]
-                + ":" + std::to_string(sortCounter) 
-                + "_" + domainHash.str()
-                + (_share_q_constants ? std::string() : "_#"+std::to_string(_q_constants_with_origin.size()));
+            size_t domainHash = USignatureHasher()(USignature(primarySort, domainVec));
             
             // Initialize q-constant
-            args[i] = nameId(qConstName, /*createQConstant=*/true, layerIdx, pos);
+            args[i] = _q_constants.getOrCreate(layerIdx, pos, primarySort, sortCounter, domainHash, _share_q_constants);
             initQConstantSorts(args[i], domain);
             domainsPerQConst[args[i]] = std::move(domainVec);
             assert(domain == getDomainOfQConstant(args[i]));
@@ -762,28 +797,28 @@ std::vector<int> HtnInstance::replaceVariablesWithQConstants(const HtnOp& op,
 void HtnInstance::initQConstantSorts(int id, const FlatHashSet<int>& domain) {
 
     // Create or retrieve the exact sort (= domain of constants) for this q-constant
-    std::string qSortName = "qsort_" + _name_back_table[id];
-    int newSortId = nameId(qSortName);
-    _constants_by_sort[newSortId].insert(domain.begin(), domain.end());
+    auto sortIt = _primary_sort_of_q_constants.find(id);
+    int newSortId;
+    if (sortIt != _primary_sort_of_q_constants.end()) newSortId = sortIt->second;
+    else {
+        newSortId = _name_table_running_id++;
+        _q_constants.setQSort(id, newSortId);
+    }
+    auto& qSortConstants = _constants_by_sort[newSortId];
+    size_t priorSize = qSortConstants.size();
+    qSortConstants.insert(domain.begin(), domain.end());
+    // Memoized domains of this (shared) q-constant are outdated if its sort grew
+    if (priorSize > 0 && qSortConstants.size() > priorSize) _eligible_args_cache.clear();
+    auto& qSortBitset = _constant_bitsets_by_sort[newSortId];
+    qSortBitset.unite(toConstantBitset(domain));
     _primary_sort_of_q_constants[id] = newSortId;
 
-    // CALCULATE ADDITIONAL SORTS OF Q CONSTANT
-
-    // 1. assume that the q-constant is of ALL (super) sorts
+    // CALCULATE ADDITIONAL SORTS OF Q CONSTANT:
+    // Each (original) sort which contains all constants of the primary sort
     FlatHashSet<int> qConstSorts;
-    for (const auto& sortPair : _p.sorts) qConstSorts.insert(nameId(sortPair.first));
-
-    // 2. for each constant of the primary sort:
-    //      remove all q-constant sorts NOT containing that constant
-    for (int c : _constants_by_sort[newSortId]) {
-        std::vector<int> sortsToRemove;
-        for (int qsort : qConstSorts) {
-            if (std::find(_constants_by_sort[qsort].begin(), _constants_by_sort[qsort].end(), c) 
-                    == _constants_by_sort[qsort].end()) {
-                sortsToRemove.push_back(qsort);
-            }
-        }
-        for (int remSort : sortsToRemove) qConstSorts.erase(remSort);
+    for (int sort : _sorts) {
+        if (qSortBitset.isSubsetOf(getConstantBitsetOfSort(sort))) 
+            qConstSorts.insert(sort);
     }
     // RESULT: The intersection of sorts of all eligible constants.
     // => If the q-constant has some sort, it means that ALL possible substitutions have that sort.
@@ -792,16 +827,24 @@ void HtnInstance::initQConstantSorts(int id, const FlatHashSet<int>& domain) {
 
 const std::vector<USignature> SIGVEC_EMPTY; 
 
-std::vector<std::vector<int>> HtnInstance::getEligibleArgs(const USignature& qSig, 
+EligibleArgs HtnInstance::getEligibleArgs(const USignature& qSig, 
         const std::vector<int>& restrictiveSorts) {
 
-    std::vector<std::vector<int>> eligibleArgs;
+    static const EligibleArgs EMPTY_ELIGIBLE_ARGS = std::make_shared<const std::vector<std::vector<int>>>();
 
     if (!hasQConstants(qSig) && isFullyGround(qSig)) 
-        return eligibleArgs;
+        return EMPTY_ELIGIBLE_ARGS;
+
+    // Normalize: the domain of a variable only depends on the sort at its position
+    USignature key(qSig._name_id, std::vector<int>());
+    key._args.reserve(qSig._args.size() + restrictiveSorts.size());
+    for (int arg : qSig._args) key._args.push_back(isVariable(arg) ? 0 : arg);
+    key._args.insert(key._args.end(), restrictiveSorts.begin(), restrictiveSorts.end());
+
+    auto it = _eligible_args_cache.find(key);
+    if (it != _eligible_args_cache.end()) return it->second;
 
-    eligibleArgs.resize(qSig._args.size());
-    size_t numChoices = 1;
+    std::vector<std::vector<int>> eligibleArgs(qSig._args.size());
     for (size_t argPos = 0; argPos < qSig._args.size(); argPos++) {
         int arg = qSig._args[argPos];
         if (isVariable(arg) || isQConstant(arg)) {
@@ -811,9 +854,9 @@ std::vector<std::vector<int>> HtnInstance::getEligibleArgs(const USignature& qSi
             if (restrictiveSorts.empty()) {
                 eligibleArgs[argPos].insert(eligibleArgs[argPos].end(), domain.begin(), domain.end());
             } else {
-                const auto& restrictiveDomain = _constants_by_sort.at(restrictiveSorts.at(argPos));
+                int restrictiveSort = restrictiveSorts.at(argPos);
                 for (int c : domain) {
-                    if (restrictiveDomain.count(c)) eligibleArgs[argPos].push_back(c);
+                    if (isConstantOfSort(c, restrictiveSort)) eligibleArgs[argPos].push_back(c);
                 }
             }
         } else {
@@ -822,19 +865,24 @@ std::vector<std::vector<int>> HtnInstance::getEligibleArgs(const USignature& qSi
         }
         //assert(eligibleArgs[argPos].size() > 0);
         if (eligibleArgs[argPos].empty()) {
-            return std::vector<std::vector<int>>();
+            eligibleArgs.clear();
+            break;
         }
-        numChoices *= eligibleArgs[argPos].size();
     }
-    return eligibleArgs;
+
+    if (_eligible_args_cache.size() >= MAX_ELIGIBLE_ARGS_CACHE_SIZE) _eligible_args_cache.clear();
+    EligibleArgs result = eligibleArgs.empty() ? EMPTY_ELIGIBLE_ARGS 
+            : std::make_shared<const std::vector<std::vector<int>>>(std::move(eligibleArgs));
+    _eligible_args_cache[std::move(key)] = result;
+    return result;
 }
 
-ArgIterator HtnInstance::decodeObjects(const USignature& qSig, std::vector<std::vector<int>> eligibleArgs) {
-    return ArgIterator(qSig._name_id, std::move(eligibleArgs));
+ArgIterator HtnInstance::decodeObjects(const USignature& qSig, const EligibleArgs& eligibleArgs) {
+    return ArgIterator(qSig._name_id, eligibleArgs);
 }
 
-SampleArgIterator HtnInstance::decodeObjects(const USignature& qSig, std::vector<std::vector<int>> eligibleArgs, size_t numSamples) {
-    return SampleArgIterator(qSig._name_id, std::move(eligibleArgs), numSamples);
+SampleArgIterator HtnInstance::decodeObjects(const USignature& qSig, const EligibleArgs& eligibleArgs, size_t numSamples) {
+    return SampleArgIterator(qSig._name_id, eligibleArgs, numSamples);
 }
 
 const std::vector<int>& HtnInstance::getSorts(int nameId) const {
@@ -845,6 +893,13 @@ const FlatHashSet<int>& HtnInstance::getConstantsOfSort(int sort) const {
     return _constants_by_sort.at(sort);
 }
 
+const ConstantBitset& HtnInstance::getConstantBitsetOfSort(int sort) const {
+    static const ConstantBitset EMPTY_BITSET;
+    auto it = _constant_bitsets_by_sort.find(sort);
+    if (it == _constant_bitsets_by_sort.end()) return EMPTY_BITSET;
+    return it->second;
+}
+
 const FlatHashSet<int>& HtnInstance::getSortsOfQConstant(int qconst) {
     return _sorts_of_q_constants[qconst];
 }
@@ -869,7 +924,7 @@ const FlatHashSet<int>& HtnInstance::getDomainOfQConstant(int qconst) const {
 }
 
 const IntPair& HtnInstance::getOriginOfQConstant(int qconst) const {
-    return _q_constants_with_origin.at(qconst);
+    return _q_constants.getOrigin(qconst);
 }
 
 std::vector<int> HtnInstance::popOperationDependentDomainOfQConstant(int qconst, const USignature& op) {
@@ -907,6 +962,7 @@ Reduction HtnInstance::toReduction(int reductionName, const std::vector<int>& ar
 USignature HtnInstance::cutNonoriginalTaskArguments(const USignature& sig) {
     USignature sigCut(sig);
     sigCut._args.resize(_original_n_taskvars[sig._name_id]);
+    sigCut.invalidateHash();
     return sigCut;
 }
 
@@ -935,6 +991,214 @@ USignature HtnInstance::getNormalizedLifted(const USignature& opSig, std::vector
     return origSig.substitute(Substitution(origSig._args, placeholderArgs)); 
 }
 
+void HtnInstance::writeSnapshot(const std::string& filename) {
+    assert(_q_constants.size() == 0 || Log::e("Snapshot must be written before any q-constants are introduced\n"));
+
+    SnapshotWriter w;
+
+    // Preprocessing options the snapshot was created with
+    w.write(_params.getIntParam("psr"));
+    w.write(_params.getIntParam("mp"));
+
+    w.write(_name_table_running_id);
+    w.write((uint64_t)_name_back_table.size());
+    for (const auto& [id, name] : _name_back_table) {
+        w.write(id);
+        w.write(name);
+    }
+    w.write(_var_ids);
+    w.write(_predicate_ids);
+    w.write(_equality_predicates);
+
+    w.write((uint64_t)_signature_sorts_table.size());
+    for (const auto& [id, sorts] : _signature_sorts_table) {
+        w.write(id);
+        w.write(sorts);
+    }
+    w.write(_sorts);
+    w.write((uint64_t)_constants_by_sort.size());
+    for (const auto& [sort, constants] : _constants_by_sort) {
+        w.write(sort);
+        w.write(constants);
+    }
+    // Dense constant IDs in the order of their indices
+    std::vector<int> denseConstants(_dense_constant_ids.size());
+    for (const auto& [c, idx] : _dense_constant_ids) denseConstants[idx] = c;
+    w.write(denseConstants);
+
+    w.write((uint64_t)_original_n_taskvars.size());
+    for (const auto& [id, n] : _original_n_taskvars) {
+        w.write(id);
+        w.write(n);
+    }
+
+    w.write((uint64_t)_operators.size());
+    for (const auto& [id, a] : _operators) {
+        w.write(a.getSignature());
+        w.write(a.getPreconditions());
+        w.write(a.getExtraPreconditions());
+        w.write(a.getEffects());
+    }
+    w.write((uint64_t)_methods.size());
+    for (const auto& [id, r] : _methods) {
+        w.write(r.getSignature());
+        w.write(r.getTaskSignature());
+        w.write((uint64_t)r.getSubtasks().size());
+        for (const auto& subtask : r.getSubtasks()) w.write(subtask);
+        w.write(r.getPreconditions());
+        w.write(r.getExtraPreconditions());
+        w.write(r.getEffects());
+    }
+    w.write((uint64_t)_task_id_to_reduction_ids.size());
+    for (const auto& [taskId, redIds] : _task_id_to_reduction_ids) {
+        w.write(taskId);
+        w.write(redIds);
+    }
+
+    w.write((uint64_t)_reduction_to_primitivization.size());
+    for (const auto& [redId, actionId] : _reduction_to_primitivization) {
+        w.write(redId);
+        w.write(actionId);
+    }
+    w.write((uint64_t)_primitivization_to_parent_and_child.size());
+    for (const auto& [actionId, pair] : _primitivization_to_parent_and_child) {
+        w.write(actionId);
+        w.write(pair.first);
+        w.write(pair.second);
+    }
+    w.write((uint64_t)_repeated_to_actual_action.size());
+    for (const auto& [repId, actionId] : _repeated_to_actual_action) {
+        w.write(repId);
+        w.write(actionId);
+    }
+
+    w.write(_blank_action_sig);
+    w.write((uint64_t)_init_facts.size());
+    for (const auto& fact : _init_facts) w.write(fact);
+    w.write(_goal_facts);
+
+    if (!w.writeToFile(filename)) {
+        Log::e("Could not write snapshot file \"%s\"!\n", filename.c_str());
+        return;
+    }
+    Log::i("Wrote snapshot of %lu bytes to %s.\n", w.size(), filename.c_str());
+}
+
+void HtnInstance::readSnapshot(const std::string& filename) {
+    SnapshotReader r(filename);
+
+    int psr = r.read<int>();
+    int mp = r.read<int>();
+    if (psr != _params.getIntParam("psr") || mp != _params.getIntParam("mp")) {
+        Log::w("Snapshot was created with -psr=%i -mp=%i; these options are used instead of the given ones.\n", psr, mp);
+    }
+
+    _name_table_running_id = r.read<int>();
+    size_t numNames = r.read<uint64_t>();
+    _name_back_table.reserve(numNames);
+    _name_table.reserve(numNames);
+    for (size_t i = 0; i < numNames; i++) {
+        int id = r.read<int>();
+        std::string name = r.readString();
+        _name_table[name] = id;
+        _name_back_table[id] = std::move(name);
+    }
+    _var_ids = r.readIntSet();
+    _predicate_ids = r.readIntSet();
+    _equality_predicates = r.readIntSet();
+
+    size_t numSortEntries = r.read<uint64_t>();
+    for (size_t i = 0; i < numSortEntries; i++) {
+        int id = r.read<int>();
+        _signature_sorts_table[id] = r.readInts();
+    }
+    _sorts = r.readInts();
+    size_t numSorts = r.read<uint64_t>();
+    for (size_t i = 0; i < numSorts; i++) {
+        int sort = r.read<int>();
+        _constants_by_sort[sort] = r.readIntSet();
+    }
+    std::vector<int> denseConstants = r.readInts();
+    for (size_t idx = 0; idx < denseConstants.size(); idx++) _dense_constant_ids[denseConstants[idx]] = idx;
+    for (int sortId : _sorts) {
+        _constant_bitsets_by_sort[sortId] = toConstantBitset(_constants_by_sort[sortId]);
+    }
+
+    size_t numTaskVarEntries = r.read<uint64_t>();
+    for (size_t i = 0; i < numTaskVarEntries; i++) {
+        int id = r.read<int>();
+        _original_n_taskvars[id] = r.read<int>();
+    }
+
+    size_t numOperators = r.read<uint64_t>();
+    for (size_t i = 0; i < numOperators; i++) {
+        USignature sig = r.readUSig();
+        Action a(sig._name_id, std::move(sig._args));
+        a.setPreconditions(r.readSigSet());
+        a.setExtraPreconditions(r.readSigSet());
+        a.setEffects(r.readSigSet());
+        _operators[a.getNameId()] = std::move(a);
+    }
+    size_t numMethods = r.read<uint64_t>();
+    for (size_t i = 0; i < numMethods; i++) {
+        USignature sig = r.readUSig();
+        Reduction red(sig._name_id, sig._args, r.readUSig());
+        size_t numSubtasks = r.read<uint64_t>();
+        std::vector<USignature> subtasks;
+        subtasks.reserve(numSubtasks);
+        for (size_t j = 0; j < numSubtasks; j++) subtasks.push_back(r.readUSig());
+        red.setSubtasks(std::move(subtasks));
+        red.setPreconditions(r.readSigSet());
+        red.setExtraPreconditions(r.readSigSet());
+        red.setEffects(r.readSigSet());
+        _methods[red.getNameId()] = std::move(red);
+    }
+    size_t numTasks = r.read<uint64_t>();
+    for (size_t i = 0; i < numTasks; i++) {
+        int taskId = r.read<int>();
+        _task_id_to_reduction_ids[taskId] = r.readInts();
+    }
+
+    size_t numPrimitivizations = r.read<uint64_t>();
+    for (size_t i = 0; i < numPrimitivizations; i++) {
+        int redId = r.read<int>();
+        _reduction_to_primitivization[redId] = r.read<int>();
+    }
+    numPrimitivizations = r.read<uint64_t>();
+    for (size_t i = 0; i < numPrimitivizations; i++) {
+        int actionId = r.read<int>();
+        int parentId = r.read<int>();
+        int childId = r.read<int>();
+        _primitivization_to_parent_and_child[actionId] = std::pair<int, int>(parentId, childId);
+    }
+    size_t numRepetitions = r.read<uint64_t>();
+    for (size_t i = 0; i < numRepetitions; i++) {
+        int repId = r.read<int>();
+        _repeated_to_actual_action[repId] = r.read<int>();
+    }
+
+    _blank_action_sig = r.readUSig();
+    BLANK_ACTION = _operators[_blank_action_sig._name_id];
+    _op_table.addAction(BLANK_ACTION);
+
+    size_t numInitFacts = r.read<uint64_t>();
+    _init_facts.reserve(numInitFacts);
+    for (size_t i = 0; i < numInitFacts; i++) _init_facts.push_back(r.readUSig());
+    _goal_facts = r.readSigSet();
+
+    if (!r.atEnd()) {
+        Log::e("Snapshot file \"%s\" has unexpected trailing data. Exiting.\n", filename.c_str());
+        exit(1);
+    }
+    Log::i("Loaded snapshot %s: %i operators and %i methods.\n", filename.c_str(), _operators.size(), _methods.size());
+}
+
+DecompositionGraph& HtnInstance::getDecompositionGraph() {
+    if (_decomposition_graph == nullptr) _decomposition_graph = new DecompositionGraph(*this);
+    return *_decomposition_graph;
+}
+
 HtnInstance::~HtnInstance() {
-    delete &_p;
+    delete _decomposition_graph;
+    delete _p;
 }
\ No newline at end of file
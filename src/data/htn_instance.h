@@ -11,12 +11,15 @@
 #include "util/params.h"
 #include "util/hashmap.h"
 #include "data/op_table.h"
+#include "data/constant_bitset.h"
+#include "data/q_constant_registry.h"
 
 #include "algo/arg_iterator.h"
 #include "algo/sample_arg_iterator.h"
 
 // Forward definitions
 class ParsedProblem;
+class DecompositionGraph;
 struct predicate_definition;
 struct task;
 struct method;
@@ -27,8 +30,11 @@ class HtnInstance {
 private:
     Parameters& _params;
 
-    // The raw parsed problem.
-    ParsedProblem& _p;
+    // The raw parsed problem (null if the instance was loaded from a snapshot
+    // without any domain and problem files).
+    ParsedProblem* _p;
+    // Whether the instance was loaded from a snapshot.
+    const bool _from_snapshot;
     
     // Maps a string to its name ID within the problem.
     FlatHashMap<std::string, int> _name_table;
@@ -43,8 +49,8 @@ private:
     FlatHashSet<int> _predicate_ids;
     // Set of equality predicate name IDs.
     FlatHashSet<int> _equality_predicates;
-    // Set of all q-constant IDs.
-    FlatHashMap<int, IntPair> _q_constants_with_origin;
+    // All q-constants introduced so far.
+    QConstantRegistry _q_constants;
 
     NodeHashMap<int, NodeHashMap<USignature, std::vector<int>, USignatureHasher>> _q_const_to_op_domains;  
 
@@ -53,6 +59,12 @@ private:
 
     // Maps a sort name ID to a set of constants of that sort.
     NodeHashMap<int, FlatHashSet<int>> _constants_by_sort;
+    // All sort name IDs of the original problem.
+    std::vector<int> _sorts;
+    // Maps each constant to a dense index used in sort bitsets.
+    FlatHashMap<int, int> _dense_constant_ids;
+    // Maps a sort name ID to the bitset of (dense indices of) constants of that sort.
+    NodeHashMap<int, ConstantBitset> _constant_bitsets_by_sort;
 
     // Maps each q-constant to the sort it was created with.
     FlatHashMap<int, int> _primary_sort_of_q_constants;
@@ -65,6 +77,10 @@ private:
     // Lookup table for the possible decodings of a fact signature with normalized arguments.    
     NodeHashMap<USignature, std::vector<USignature>, USignatureHasher> _fact_sig_decodings;
 
+    // Memoized argument domains of q-facts, keyed by the normalized q-fact
+    // (variables replaced by 0) followed by the restrictive sorts.
+    FlatHashMap<USignature, EligibleArgs, USignatureHasher> _eligible_args_cache;
+
     // Maps an action name ID to its action object.
     NodeHashMap<int, Action> _operators;
     // Maps a reduction name ID to its reduction object.
@@ -73,6 +89,9 @@ private:
     // Lookup for all actions and reductions instantiated so far.
     OpTable _op_table;
 
+    // Compiled decomposition graph of the lifted reductions (created on first use).
+    DecompositionGraph* _decomposition_graph = nullptr;
+
     // Maps a task name ID to the name IDs of possible reductions for the task.
     NodeHashMap<int, std::vector<int>> _task_id_to_reduction_ids;
 
@@ -84,6 +103,10 @@ private:
 
     FlatHashMap<int, int> _repeated_to_actual_action;
 
+    // Positive facts of the initial state (without equality facts) and goal facts.
+    std::vector<USignature> _init_facts;
+    SigSet _goal_facts;
+
     // The initial reduction of the problem.
     Reduction _init_reduction;
     // Signature of the BLANK virtual action.
@@ -119,6 +142,7 @@ public:
     const Action& getActionTemplate(int nameId) const;
     const Reduction& getReductionTemplate(int nameId) const;
     OpTable& getOpTable() {return _op_table;}
+    DecompositionGraph& getDecompositionGraph();
 
     bool hasReductions(int taskId) const;
     const std::vector<int>& getReductionIdsOfTaskId(int taskId) const;
@@ -134,6 +158,13 @@ public:
 
     const std::vector<int>& getSorts(int nameId) const;
     const FlatHashSet<int>& getConstantsOfSort(int sort) const;
+    const ConstantBitset& getConstantBitsetOfSort(int sort) const;
+    ConstantBitset toConstantBitset(const FlatHashSet<int>& constants) const;
+
+    inline bool isConstantOfSort(int constant, int sort) const {
+        auto it = _dense_constant_ids.find(constant);
+        return it != _dense_constant_ids.end() && getConstantBitsetOfSort(sort).test(it->second);
+    }
     const FlatHashSet<int>& getSortsOfQConstant(int qconst);
     const IntPair& getOriginOfQConstant(int qconst) const;
     const FlatHashSet<int>& getDomainOfQConstant(int qconst) const;
@@ -141,9 +172,17 @@ public:
 
     std::vector<int> getOpSortsForCondition(const USignature& sig, const USignature& op);
 
-    std::vector<std::vector<int>> getEligibleArgs(const USignature& qFact, const std::vector<int>& restrictiveSorts = std::vector<int>());
-    ArgIterator decodeObjects(const USignature& qSig, std::vector<std::vector<int>> eligibleArgs);
-    SampleArgIterator decodeObjects(const USignature& qSig, std::vector<std::vector<int>> eligibleArgs, size_t numSamples);
+    // Returns the domain of eligible constants for each argument of the given q-fact.
+    // The result is memoized and shared; it is empty if the q-fact cannot be decoded.
+    EligibleArgs getEligibleArgs(const USignature& qFact, const std::vector<int>& restrictiveSorts = std::vector<int>());
+    ArgIterator decodeObjects(const USignature& qSig, const EligibleArgs& eligibleArgs);
+    SampleArgIterator decodeObjects(const USignature& qSig, const EligibleArgs& eligibleArgs, size_t numSamples);
+    // Calls f(const USignature&) for each decoding of the q-signature until f returns false.
+    // Returns false iff the decoding was stopped by f.
+    template <typename F>
+    bool forEachDecoding(const USignature& qSig, const EligibleArgs& eligibleArgs, F&& f) {
+        return ArgIterator::forEach(qSig._name_id, *eligibleArgs, f);
+    }
 
     Action replaceVariablesWithQConstants(const Action& a, const std::vector<FlatHashSet<int>>& opArgDomains, int layerIdx, int pos);
     Reduction replaceVariablesWithQConstants(const Reduction& red, const std::vector<FlatHashSet<int>>& opArgDomains, int layerIdx, int pos);
@@ -153,12 +192,13 @@ public:
     USignature cutNonoriginalTaskArguments(const USignature& sig);
     const std::pair<int, int>& getReductionAndActionFromPrimitivization(int primitivizationName);
 
-    int nameId(const std::string& name, bool createQConstant = false, int layerIdx = -1, int pos = -1);
+    int nameId(const std::string& name);
     std::string toString(int id) const;
 
     inline bool isVariable(int c) const {
         if (c < 0) return true;
-        assert(_name_back_table.count(c) || Log::d("%i not in name_back_table !\n", c));
+        assert(_name_back_table.count(c) || _q_constants.isQConstant(c) || _q_constants.isQSort(c) 
+                || Log::d("%i not in name_back_table !\n", c));
         return _var_ids.count(c);
     }
 
@@ -171,7 +211,13 @@ public:
         return false;
     }
 
-    inline ParsedProblem& getParsedProblem() {return _p;}
+    inline ParsedProblem& getParsedProblem() {assert(_p != nullptr); return *_p;}
+
+    bool hasParsedProblem() const {return _p != nullptr;}
+    bool isLoadedFromSnapshot() const {return _from_snapshot;}
+    // Writes the (preprocessed) instance into a binary snapshot file which 
+    // can be loaded via the parameter -snapshot-in instead of parsing the problem.
+    void writeSnapshot(const std::string& filename);
 
     bool isUnifiable(const Signature& from, const Signature& to, FlatHashMap<int, int>* substitution = nullptr) {
         if (from._negated != to._negated) return false;
@@ -239,16 +285,12 @@ public:
             if (isVariable(arg)) continue; // skip variable
             bool valid = false;
             if (isQConstant(arg)) {
-                // q constant: TODO check if SOME SUBSTITUTEABLE CONSTANT has the correct sort
-                for (int cnst : getDomainOfQConstant(arg)) {
-                    if (getConstantsOfSort(sort).count(cnst)) {
-                        valid = true;
-                        break;
-                    }
-                }
+                // q constant: check if SOME SUBSTITUTEABLE CONSTANT has the correct sort
+                valid = getConstantBitsetOfSort(_primary_sort_of_q_constants.at(arg))
+                        .intersects(getConstantBitsetOfSort(sort));
             } else {
                 // normal constant: check if it is contained in the correct sort
-                valid = getConstantsOfSort(sort).count(arg);
+                valid = isConstantOfSort(arg, sort);
             }
             if (!valid) {
                 //log("arg %s not of sort %s => %s invalid\n", TOSTR(arg), TOSTR(sort), TOSTR(sig));
@@ -258,6 +300,10 @@ public:
         return true;
     }
 
+    const FlatHashSet<int>& getPredicateIds() const {
+        return _predicate_ids;
+    }
+
     inline bool isPredicate(int nameId) const {
         return _predicate_ids.count(nameId);
     }
@@ -271,7 +317,7 @@ public:
     }
 
     inline size_t getNumberOfQConstants() const {
-        return _q_constants_with_origin.size();
+        return _q_constants.size();
     }
 
     std::vector<TypeConstraint> getQConstantTypeConstraints(const USignature& sig) {
@@ -286,7 +332,7 @@ public:
             // Not a q-constant here
             if (!isQConstant(arg)) {
                 // Must be of valid type
-                assert(getConstantsOfSort(sigSort).count(arg));
+                assert(isConstantOfSort(arg, sigSort));
                 continue;
             }
 
@@ -296,11 +342,10 @@ public:
             // Type is NOT fine, at least for some substitutions
             std::vector<int> good;
             std::vector<int> bad;
-            const FlatHashSet<int>& validConstants = getConstantsOfSort(sigSort);
             // For each value the qconstant can assume:
             for (int c : getDomainOfQConstant(arg)) {
                 // Is that constant of correct type?
-                if (validConstants.count(c)) good.push_back(c);
+                if (isConstantOfSort(c, sigSort)) good.push_back(c);
                 else bad.push_back(c);
             }
 
@@ -332,6 +377,8 @@ private:
     void extractConstants();
     SigSet extractEqualityConstraints(int opId, const std::vector<literal>& lits, const std::vector<std::pair<std::string, std::string>>& vars);
     SigSet extractGoals();
+    void extractInitFactsAndGoals();
+    void readSnapshot(const std::string& filename);
 
     Reduction& createReduction(method& method);
     Action& createAction(const task& task);
@@ -2,42 +2,126 @@
 #ifndef DOMPASCH_LILOTANE_OP_TABLE_H
 #define DOMPASCH_LILOTANE_OP_TABLE_H
 
+#include <algorithm>
+
 #include "data/signature.h"
 #include "data/action.h"
 #include "data/reduction.h"
 
+/*
+Lookup for all ground and pseudo-ground operations instantiated so far.
+Each such operation is a full substitution of one of the (lifted) templates,
+so only its signature (template name ID + arguments) is stored. The actual
+operation objects are materialized on demand and kept in a bounded cache.
+References returned by getAction / getReduction remain valid until the next
+call to trimCache(), which must only be called where no such references are held.
+*/
 class OpTable {
 
 private:
-    // Maps a signature of a ground or pseudo-ground action to the actual action object.
-    NodeHashMap<USignature, Action, USignatureHasher> _actions_by_sig;
-    // Maps a signature of a ground or pseudo-ground reduction to the actual reduction object.
-    NodeHashMap<USignature, Reduction, USignatureHasher> _reductions_by_sig;
+    template <class Op>
+    struct CachedOp {
+        Op op;
+        size_t lastAccess;
+        CachedOp(Op&& op, size_t lastAccess) : op(std::move(op)), lastAccess(lastAccess) {}
+    };
+
+    // The action templates, by name ID.
+    const NodeHashMap<int, Action>& _action_templates;
+    // The reduction templates, by name ID.
+    const NodeHashMap<int, Reduction>& _reduction_templates;
+
+    // Signatures of all ground or pseudo-ground actions.
+    USigSet _action_sigs;
+    // Signatures of all ground or pseudo-ground reductions.
+    USigSet _reduction_sigs;
+
+    // Materialized operations, with the "time" of their last access.
+    mutable NodeHashMap<USignature, CachedOp<Action>, USignatureHasher> _action_cache;
+    mutable NodeHashMap<USignature, CachedOp<Reduction>, USignatureHasher> _reduction_cache;
+    mutable size_t _access_counter = 0;
+
+    // Max. number of materialized operations (of each kind) kept after trimming (0: no limit).
+    size_t _max_cache_size = 0;
 
 public:
-    
+    OpTable(const NodeHashMap<int, Action>& actionTemplates, const NodeHashMap<int, Reduction>& reductionTemplates) :
+        _action_templates(actionTemplates), _reduction_templates(reductionTemplates) {}
+
+    void setMaxCacheSize(size_t maxCacheSize) {
+        _max_cache_size = maxCacheSize;
+    }
+
     void addAction(const Action& a) {
-        _actions_by_sig[a.getSignature()] = a;
+        _action_sigs.insert(a.getSignature());
     }
-    
+
     void addReduction(const Reduction& r) {
-        _reductions_by_sig[r.getSignature()] = r;
+        _reduction_sigs.insert(r.getSignature());
     }
 
     bool hasAction(const USignature& sig) const {
-        return _actions_by_sig.count(sig);
+        return _action_sigs.count(sig);
     }
 
     bool hasReduction(const USignature& sig) const {
-        return _reductions_by_sig.count(sig);
+        return _reduction_sigs.count(sig);
     }
-    
+
     const Action& getAction(const USignature& sig) const {
-        return _actions_by_sig.at(sig);
+        auto it = _action_cache.find(sig);
+        if (it != _action_cache.end()) {
+            it->second.lastAccess = ++_access_counter;
+            return it->second.op;
+        }
+        assert(hasAction(sig));
+        const Action& templ = _action_templates.at(sig._name_id);
+        Action a = templ.substitute(Substitution(templ.getArguments(), sig._args));
+        a.removeInconsistentEffects();
+        return _action_cache.emplace(sig, CachedOp<Action>(std::move(a), ++_access_counter)).first->second.op;
     }
-    
+
     const Reduction& getReduction(const USignature& sig) const {
-        return _reductions_by_sig.at(sig);
+        auto it = _reduction_cache.find(sig);
+        if (it != _reduction_cache.end()) {
+            it->second.lastAccess = ++_access_counter;
+            return it->second.op;
+        }
+        assert(hasReduction(sig));
+        const Reduction& templ = _reduction_templates.at(sig._name_id);
+        Reduction r = templ.substituteRed(Substitution(templ.getArguments(), sig._args));
+        return _reduction_cache.emplace(sig, CachedOp<Reduction>(std::move(r), ++_access_counter)).first->second.op;
+    }
+
+    // Drops the least recently used materialized operations
+    // such that at most the max. cache size remains of each kind.
+    void trimCache() {
+        if (_max_cache_size == 0) return;
+        trim(_action_cache);
+        trim(_reduction_cache);
+    }
+
+    size_t getNumCachedOps() const {
+        return _action_cache.size() + _reduction_cache.size();
+    }
+
+private:
+    template <class Op>
+    void trim(NodeHashMap<USignature, CachedOp<Op>, USignatureHasher>& cache) {
+        if (cache.size() <= _max_cache_size) return;
+
+        // Find the access time separating the entries to keep from the ones to drop
+        std::vector<size_t> accesses;
+        accesses.reserve(cache.size());
+        for (const auto& [sig, cached] : cache) accesses.push_back(cached.lastAccess);
+        size_t numToDrop = cache.size() - _max_cache_size;
+        std::nth_element(accesses.begin(), accesses.begin() + numToDrop - 1, accesses.end());
+        size_t threshold = accesses[numToDrop - 1];
+
+        for (auto it = cache.begin(); it != cache.end();) {
+            if (it->second.lastAccess <= threshold) it = cache.erase(it);
+            else ++it;
+        }
     }
 };
 
@@ -6,12 +6,16 @@
 
 NodeHashMap<USignature, USigSet, USignatureHasher> Position::EMPTY_USIG_TO_USIG_SET_MAP;
 IndirectFactSupportMap Position::EMPTY_INDIRECT_FACT_SUPPORT_MAP;
+NodeHashMap<USignature, USigSubstitutionMap, USignatureHasher> Position::EMPTY_EXPANSION_SUBSTITUTION_MAP;
+NodeHashMap<USignature, std::vector<TypeConstraint>, USignatureHasher> Position::EMPTY_TYPE_CONSTRAINT_MAP;
+NodeHashMap<USignature, std::vector<SubstitutionConstraint>, USignatureHasher> Position::EMPTY_SUBSTITUTION_CONSTRAINT_MAP;
 
 Position::Position() : _layer_idx(-1), _pos(-1) {}
 void Position::setPos(size_t layerIdx, size_t pos) {_layer_idx = layerIdx; _pos = pos;}
 
 void Position::addQFact(const USignature& qfact) {
-    _qfacts.insert(qfact);
+    if (_qfacts == nullptr) _qfacts = new USigSet();
+    _qfacts->insert(qfact);
 }
 void Position::addTrueFact(const USignature& fact) {_true_facts.insert(fact);}
 void Position::addFalseFact(const USignature& fact) {_false_facts.insert(fact);}
@@ -53,34 +57,69 @@ bool Position::hasNonprimitiveOps() {
 }
 
 void Position::addQConstantTypeConstraint(const USignature& op, const TypeConstraint& c) {
-    auto& vec = _q_constants_type_constraints[op];
+    if (_q_constants_type_constraints == nullptr) 
+        _q_constants_type_constraints = new NodeHashMap<USignature, std::vector<TypeConstraint>, USignatureHasher>();
+    auto& vec = (*_q_constants_type_constraints)[op];
     vec.push_back(c);
 }
 
 void Position::addSubstitutionConstraint(const USignature& op, SubstitutionConstraint&& constr) {
-    _substitution_constraints[op].emplace_back(std::move(constr));
+    if (_substitution_constraints == nullptr) {
+        _substitution_constraints = new NodeHashMap<USignature, std::vector<SubstitutionConstraint>, USignatureHasher>();
+        _substitution_constraint_indices = new NodeHashMap<USignature, SubstitutionConstraintIndex, USignatureHasher>();
+    }
+    auto& constraints = (*_substitution_constraints)[op];
+    if (constr.getPolarity() == SubstitutionConstraint::UNDECIDED) {
+        // Cannot be merged with anything
+        constraints.emplace_back(std::move(constr));
+        return;
+    }
+
+    // Merge into the constraint with the same polarity and q-constants, if present
+    auto& index = (*_substitution_constraint_indices)[op][constr.getPolarity() == SubstitutionConstraint::ANY_VALID ? 0 : 1];
+    auto it = index.find(constr.getInvolvedQConstants());
+    if (it != index.end()) {
+        constraints[it->second].merge(std::move(constr));
+        return;
+    }
+    index[constr.getInvolvedQConstants()] = constraints.size();
+    constraints.emplace_back(std::move(constr));
+}
+
+void Position::findSubstitutionConstraints(const USignature& op, const std::vector<int>& involvedQConsts, 
+        std::vector<SubstitutionConstraint*>& result) {
+    if (_substitution_constraint_indices == nullptr) return;
+    auto indexIt = _substitution_constraint_indices->find(op);
+    if (indexIt == _substitution_constraint_indices->end()) return;
+    auto& constraints = _substitution_constraints->at(op);
+    for (const auto& index : indexIt->second) {
+        auto it = index.find(involvedQConsts);
+        if (it != index.end()) result.push_back(&constraints[it->second]);
+    }
 }
 
 void Position::addQFactDecoding(const USignature& qFact, const USignature& decFact, bool negated) {
     auto& set = negated ? _neg_qfact_decodings : _pos_qfact_decodings;
-    set[qFact].insert(decFact);
+    if (set == nullptr) set = new NodeHashMap<USignature, USigSet, USignatureHasher>();
+    (*set)[qFact].insert(decFact);
     //Log::v("QFACTDEC %s -> %s (%s)\n", TOSTR(qFact), TOSTR(decFact), negated?"false":"true");
 }
 
 void Position::removeQFactDecoding(const USignature& qFact, const USignature& decFact, bool negated) {
     auto& set = negated ? _neg_qfact_decodings : _pos_qfact_decodings;
-    set[qFact].erase(decFact);
+    if (set == nullptr) set = new NodeHashMap<USignature, USigSet, USignatureHasher>();
+    (*set)[qFact].erase(decFact);
 }
 
 bool Position::hasQFactDecodings(const USignature& qFact, bool negated) {
     auto& set = negated ? _neg_qfact_decodings : _pos_qfact_decodings;
-    return set.count(qFact);
+    return set != nullptr && set->count(qFact);
 }
 
 const USigSet& Position::getQFactDecodings(const USignature& qFact, bool negated) {
     auto& set = negated ? _neg_qfact_decodings : _pos_qfact_decodings;
-    assert(set.count(qFact) || Log::e("No qfact decodings for %s!\n", TOSTR(qFact)));
-    return set.at(qFact);
+    assert(hasQFactDecodings(qFact, negated) || Log::e("No qfact decodings for %s!\n", TOSTR(qFact)));
+    return set->at(qFact);
 }
 
 void Position::addAction(const USignature& action) {
@@ -102,10 +141,14 @@ void Position::addExpansion(const USignature& parent, const USignature& child) {
     pred.insert(parent);
 }
 void Position::addExpansionSubstitution(const USignature& parent, const USignature& child, Substitution&& s) {
-    _expansion_substitutions[parent][child] = std::move(s);
+    if (_expansion_substitutions == nullptr) 
+        _expansion_substitutions = new NodeHashMap<USignature, USigSubstitutionMap, USignatureHasher>();
+    (*_expansion_substitutions)[parent][child] = std::move(s);
 }
 void Position::addExpansionSubstitution(const USignature& parent, const USignature& child, const Substitution& s) {
-    _expansion_substitutions[parent][child] = s;
+    if (_expansion_substitutions == nullptr) 
+        _expansion_substitutions = new NodeHashMap<USignature, USigSubstitutionMap, USignatureHasher>();
+    (*_expansion_substitutions)[parent][child] = s;
 }
 void Position::addAxiomaticOp(const USignature& op) {
     _axiomatic_ops.insert(op);
@@ -114,6 +157,10 @@ void Position::addExpansionSize(size_t size) {_max_expansion_size = std::max(_ma
 
 void Position::removeActionOccurrence(const USignature& action) {
     _actions.erase(action);
+    if (_frozen_expansions != nullptr) {
+        _frozen_expansions->removeOccurrence(action);
+        return;
+    }
     for (auto& [parent, children] : _expansions) {
         children.erase(action);
     }
@@ -121,6 +168,10 @@ void Position::removeActionOccurrence(const USignature& action) {
 }
 void Position::removeReductionOccurrence(const USignature& reduction) {
     _reductions.erase(reduction);
+    if (_frozen_expansions != nullptr) {
+        _frozen_expansions->removeOccurrence(reduction);
+        return;
+    }
     for (auto& [parent, children] : _expansions) {
         children.erase(reduction);
     }
@@ -154,14 +205,17 @@ void Position::moveVariableTable(VarType type, Position& destination) {
     src.reserve(0);
 }
 
-bool Position::hasQFact(const USignature& fact) const {return _qfacts.count(fact);}
+bool Position::hasQFact(const USignature& fact) const {return _qfacts != nullptr && _qfacts->count(fact);}
 bool Position::hasAction(const USignature& action) const {return _actions.count(action);}
 bool Position::hasReduction(const USignature& red) const {return _reductions.count(red);}
 
 size_t Position::getLayerIndex() const {return _layer_idx;}
 size_t Position::getPositionIndex() const {return _pos;}
 
-const USigSet& Position::getQFacts() const {return _qfacts;}
+const USigSet& Position::getQFacts() const {
+    if (_qfacts == nullptr) return Sig::EMPTY_USIG_SET;
+    return *_qfacts;
+}
 const USigSet& Position::getTrueFacts() const {return _true_facts;}
 const USigSet& Position::getFalseFacts() const {return _false_facts;}
 NodeHashMap<USignature, USigSet, USignatureHasher>& Position::getPosFactSupports() {
@@ -181,47 +235,95 @@ IndirectFactSupportMap& Position::getNegIndirectFactSupports() {
     return *_neg_indir_fact_supports;
 }
 const NodeHashMap<USignature, std::vector<TypeConstraint>, USignatureHasher>& Position::getQConstantsTypeConstraints() const {
-    return _q_constants_type_constraints;
+    if (_q_constants_type_constraints == nullptr) return EMPTY_TYPE_CONSTRAINT_MAP;
+    return *_q_constants_type_constraints;
 }
 
 USigSet& Position::getActions() {return _actions;}
 const USigSet& Position::getReductions() const {return _reductions;}
-NodeHashMap<USignature, USigSet, USignatureHasher>& Position::getExpansions() {return _expansions;}
-NodeHashMap<USignature, USigSet, USignatureHasher>& Position::getPredecessors() {return _predecessors;}
-const NodeHashMap<USignature, USigSubstitutionMap, USignatureHasher>& Position::getExpansionSubstitutions() const {return _expansion_substitutions;}
+NodeHashMap<USignature, USigSet, USignatureHasher>& Position::getExpansions() {
+    assert(_frozen_expansions == nullptr);
+    return _expansions;
+}
+NodeHashMap<USignature, USigSet, USignatureHasher>& Position::getPredecessors() {
+    assert(_frozen_expansions == nullptr);
+    return _predecessors;
+}
+const NodeHashMap<USignature, USigSubstitutionMap, USignatureHasher>& Position::getExpansionSubstitutions() const {
+    if (_expansion_substitutions == nullptr) return EMPTY_EXPANSION_SUBSTITUTION_MAP;
+    return *_expansion_substitutions;
+}
 const USigSet& Position::getAxiomaticOps() const {return _axiomatic_ops;}
 size_t Position::getMaxExpansionSize() const {return _max_expansion_size;}
 
+bool Position::hasExpansionsOf(const USignature& parent) const {
+    if (_frozen_expansions != nullptr) return _frozen_expansions->hasExpansions(parent);
+    return _expansions.count(parent);
+}
+bool Position::hasPredecessorsOf(const USignature& child) const {
+    if (_frozen_expansions != nullptr) return _frozen_expansions->hasPredecessors(child);
+    return _predecessors.count(child);
+}
+std::vector<USignature> Position::getExpansionsOf(const USignature& parent) const {
+    if (_frozen_expansions != nullptr) return _frozen_expansions->getExpansions(parent);
+    const auto& children = _expansions.at(parent);
+    return std::vector<USignature>(children.begin(), children.end());
+}
+std::vector<USignature> Position::getPredecessorsOf(const USignature& child) const {
+    if (_frozen_expansions != nullptr) return _frozen_expansions->getPredecessors(child);
+    const auto& parents = _predecessors.at(child);
+    return std::vector<USignature>(parents.begin(), parents.end());
+}
+size_t Position::getNumExpansionsOf(const USignature& parent) const {
+    if (_frozen_expansions != nullptr) return _frozen_expansions->getNumExpansions(parent);
+    return _expansions.at(parent).size();
+}
+size_t Position::getNumPredecessorsOf(const USignature& child) const {
+    if (_frozen_expansions != nullptr) return _frozen_expansions->getNumPredecessors(child);
+    return _predecessors.at(child).size();
+}
+bool Position::hasExpansion(const USignature& parent, const USignature& child) const {
+    if (_frozen_expansions != nullptr) return _frozen_expansions->hasExpansion(parent, child);
+    auto it = _expansions.find(parent);
+    return it != _expansions.end() && it->second.count(child);
+}
+void Position::removePredecessor(const USignature& child, const USignature& parent) {
+    if (_frozen_expansions != nullptr) {
+        _frozen_expansions->removePredecessor(child, parent);
+        return;
+    }
+    _predecessors.at(child).erase(parent);
+}
+
 void Position::clearAfterInstantiation() {
 }
 
 void Position::clearAtPastPosition() {
-    _qfacts.clear();
-    _qfacts.reserve(0);
-    /*
-    _expansions.clear();
-    _expansions.reserve(0);
-    _predecessors.clear();
-    _predecessors.reserve(0);
-    */
-   _expansion_substitutions.clear();
-   _expansion_substitutions.reserve(0);
+    if (_qfacts != nullptr) delete _qfacts;
+    _qfacts = nullptr;
+    freezeExpansions();
+    if (_expansion_substitutions != nullptr) delete _expansion_substitutions;
+    _expansion_substitutions = nullptr;
     _axiomatic_ops.clear();
     _axiomatic_ops.reserve(0);
-    _q_constants_type_constraints.clear();
-    _q_constants_type_constraints.reserve(0);
+    if (_q_constants_type_constraints != nullptr) delete _q_constants_type_constraints;
+    _q_constants_type_constraints = nullptr;
     clearSubstitutions();
     if (_pos_fact_supports != nullptr) delete _pos_fact_supports;
     if (_neg_fact_supports != nullptr) delete _neg_fact_supports;
     if (_pos_indir_fact_supports != nullptr) delete _pos_indir_fact_supports;
     if (_neg_indir_fact_supports != nullptr) delete _neg_indir_fact_supports;
+    _pos_fact_supports = nullptr;
+    _neg_fact_supports = nullptr;
+    _pos_indir_fact_supports = nullptr;
+    _neg_indir_fact_supports = nullptr;
 }
 
 void Position::clearAtPastLayer() {
-    _pos_qfact_decodings.clear();
-    _pos_qfact_decodings.reserve(0);
-    _neg_qfact_decodings.clear();
-    _neg_qfact_decodings.reserve(0);
+    if (_pos_qfact_decodings != nullptr) delete _pos_qfact_decodings;
+    if (_neg_qfact_decodings != nullptr) delete _neg_qfact_decodings;
+    _pos_qfact_decodings = nullptr;
+    _neg_qfact_decodings = nullptr;
     _true_facts.clear();
     _true_facts.reserve(0);
     _false_facts.clear();
@@ -234,4 +336,13 @@ void Position::clearAtPastLayer() {
     _reductions.clear();
     _reductions.reserve(0);
     */
-}
\ No newline at end of file
+}
+
+void Position::freezeExpansions() {
+    if (_frozen_expansions != nullptr) return;
+    _frozen_expansions = new FrozenExpansions(_expansions, _predecessors);
+    _expansions.clear();
+    _expansions.reserve(0);
+    _predecessors.clear();
+    _predecessors.reserve(0);
+}
@@ -4,6 +4,7 @@
 
 #include <vector>
 #include <set>
+#include <array>
 
 #include "util/hashmap.h"
 #include "data/signature.h"
@@ -12,10 +13,13 @@
 #include "util/log.h"
 #include "sat/literal_tree.h"
 #include "data/substitution_constraint.h"
+#include "data/frozen_expansions.h"
 
 typedef NodeHashMap<USignature, IntPairTree, USignatureHasher> IndirectFactSupportMapEntry;
 typedef NodeHashMap<USignature, IndirectFactSupportMapEntry, USignatureHasher> IndirectFactSupportMap;
 typedef NodeHashMap<USignature, Substitution, USignatureHasher> USigSubstitutionMap;
+// For ANY_VALID and NO_INVALID: involved q-constants -> index of the operation's constraint over them.
+typedef std::array<FlatHashMap<std::vector<int>, size_t, IntVecHasher>, 2> SubstitutionConstraintIndex;
 
 enum VarType { FACT, OP };
 
@@ -24,6 +28,9 @@ struct Position {
 public:
     static NodeHashMap<USignature, USigSet, USignatureHasher> EMPTY_USIG_TO_USIG_SET_MAP;
     static IndirectFactSupportMap EMPTY_INDIRECT_FACT_SUPPORT_MAP;
+    static NodeHashMap<USignature, USigSubstitutionMap, USignatureHasher> EMPTY_EXPANSION_SUBSTITUTION_MAP;
+    static NodeHashMap<USignature, std::vector<TypeConstraint>, USignatureHasher> EMPTY_TYPE_CONSTRAINT_MAP;
+    static NodeHashMap<USignature, std::vector<SubstitutionConstraint>, USignatureHasher> EMPTY_SUBSTITUTION_CONSTRAINT_MAP;
 
 private:
     size_t _layer_idx;
@@ -34,15 +41,18 @@ private:
 
     NodeHashMap<USignature, USigSet, USignatureHasher> _expansions;
     NodeHashMap<USignature, USigSet, USignatureHasher> _predecessors;
-    NodeHashMap<USignature, USigSubstitutionMap, USignatureHasher> _expansion_substitutions;
+    // Rarely used structures below are only allocated on first use.
+    NodeHashMap<USignature, USigSubstitutionMap, USignatureHasher>* _expansion_substitutions = nullptr;
+    // Compact replacement of _expansions and _predecessors once this position is done.
+    FrozenExpansions* _frozen_expansions = nullptr;
 
     USigSet _axiomatic_ops;
 
     // All VIRTUAL facts potentially occurring at this position.
-    USigSet _qfacts;
+    USigSet* _qfacts = nullptr;
     // Maps a q-fact to the set of possibly valid decoded facts.
-    NodeHashMap<USignature, USigSet, USignatureHasher> _pos_qfact_decodings;
-    NodeHashMap<USignature, USigSet, USignatureHasher> _neg_qfact_decodings;
+    NodeHashMap<USignature, USigSet, USignatureHasher>* _pos_qfact_decodings = nullptr;
+    NodeHashMap<USignature, USigSet, USignatureHasher>* _neg_qfact_decodings = nullptr;
 
     // All facts that are definitely true at this position.
     USigSet _true_facts;
@@ -54,8 +64,10 @@ private:
     IndirectFactSupportMap* _pos_indir_fact_supports = nullptr;
     IndirectFactSupportMap* _neg_indir_fact_supports = nullptr;
 
-    NodeHashMap<USignature, std::vector<TypeConstraint>, USignatureHasher> _q_constants_type_constraints;
-    NodeHashMap<USignature, std::vector<SubstitutionConstraint>, USignatureHasher> _substitution_constraints;
+    NodeHashMap<USignature, std::vector<TypeConstraint>, USignatureHasher>* _q_constants_type_constraints = nullptr;
+    NodeHashMap<USignature, std::vector<SubstitutionConstraint>, USignatureHasher>* _substitution_constraints = nullptr;
+    // Constraints of the same polarity over the same q-constants are merged on insertion.
+    NodeHashMap<USignature, SubstitutionConstraintIndex, USignatureHasher>* _substitution_constraint_indices = nullptr;
 
     size_t _max_expansion_size = 1;
 
@@ -124,8 +136,12 @@ public:
     IndirectFactSupportMap& getNegIndirectFactSupports();
     const NodeHashMap<USignature, std::vector<TypeConstraint>, USignatureHasher>& getQConstantsTypeConstraints() const;
     NodeHashMap<USignature, std::vector<SubstitutionConstraint>, USignatureHasher>& getSubstitutionConstraints() {
-        return _substitution_constraints;
+        if (_substitution_constraints == nullptr) return EMPTY_SUBSTITUTION_CONSTRAINT_MAP;
+        return *_substitution_constraints;
     }
+    // Appends the constraints of the operation over exactly the given q-constants (at most one per polarity).
+    void findSubstitutionConstraints(const USignature& op, const std::vector<int>& involvedQConsts, 
+            std::vector<SubstitutionConstraint*>& result);
 
     USigSet& getActions();
     const USigSet& getReductions() const;
@@ -133,6 +149,16 @@ public:
     NodeHashMap<USignature, USigSet, USignatureHasher>& getPredecessors();
     const NodeHashMap<USignature, USigSubstitutionMap, USignatureHasher>& getExpansionSubstitutions() const;
     const USigSet& getAxiomaticOps() const;
+
+    // Lookups which work before and after the expansions have been frozen.
+    bool hasExpansionsOf(const USignature& parent) const;
+    bool hasPredecessorsOf(const USignature& child) const;
+    std::vector<USignature> getExpansionsOf(const USignature& parent) const;
+    std::vector<USignature> getPredecessorsOf(const USignature& child) const;
+    size_t getNumExpansionsOf(const USignature& parent) const;
+    size_t getNumPredecessorsOf(const USignature& child) const;
+    bool hasExpansion(const USignature& parent, const USignature& child) const;
+    void removePredecessor(const USignature& child, const USignature& parent);
     size_t getMaxExpansionSize() const;
 
     size_t getLayerIndex() const;
@@ -141,9 +167,12 @@ public:
     void clearAfterInstantiation();
     void clearAtPastPosition();
     void clearAtPastLayer();
+    void freezeExpansions();
     void clearSubstitutions() {
-        _substitution_constraints.clear();
-        _substitution_constraints.reserve(0);
+        if (_substitution_constraints != nullptr) delete _substitution_constraints;
+        if (_substitution_constraint_indices != nullptr) delete _substitution_constraint_indices;
+        _substitution_constraints = nullptr;
+        _substitution_constraint_indices = nullptr;
     }
 
     inline int encode(VarType type, const USignature& sig) {
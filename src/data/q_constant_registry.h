@@ -0,0 +1,115 @@
+
+#ifndef DOMPASCH_LILOTANE_Q_CONSTANT_REGISTRY_H
+#define DOMPASCH_LILOTANE_Q_CONSTANT_REGISTRY_H
+
+#include <limits>
+#include <string>
+#include <sstream>
+
+#include "util/hashmap.h"
+#include "util/hash.h"
+#include "data/signature.h"
+
+/*
+Numeric registry of all q-constants introduced so far.
+A q-constant is identified by its origin (layer, position), its primary sort,
+a counter distinguishing several q-constants of the same sort at the same operation,
+and a hash of its domain. No names are stored: human-readable names of q-constants
+and of their exact sorts are assembled on demand (for logging and output only).
+*/
+class QConstantRegistry {
+
+public:
+    struct Record {
+        IntPair origin;
+        int primarySort;
+        int sortCounter;
+        size_t domainHash;
+        // Running index of the q-constant, or -1 if q-constants are shared
+        // among all operations with the same key.
+        int uniqueIdx;
+    };
+
+private:
+    struct Key {
+        IntPair origin;
+        int primarySort;
+        int sortCounter;
+        size_t domainHash;
+        bool operator==(const Key& other) const {
+            return origin == other.origin && primarySort == other.primarySort
+                && sortCounter == other.sortCounter && domainHash == other.domainHash;
+        }
+    };
+    struct KeyHasher {
+        std::size_t operator()(const Key& k) const {
+            size_t hash = k.domainHash;
+            hash_combine(hash, k.origin.first);
+            hash_combine(hash, k.origin.second);
+            hash_combine(hash, k.primarySort);
+            hash_combine(hash, k.sortCounter);
+            return hash;
+        }
+    };
+
+    FlatHashMap<int, Record> _records;
+    // Only populated if q-constants are shared.
+    FlatHashMap<Key, int, KeyHasher> _ids_by_key;
+    // Maps the ID of each exact q-constant sort to its q-constant.
+    FlatHashMap<int, int> _q_constants_by_q_sort;
+
+public:
+    // Returns the ID of the q-constant with the given properties. If shared, a q-constant
+    // with the same properties is reused; otherwise, a new q-constant is always created.
+    int getOrCreate(int layerIdx, int pos, int primarySort, int sortCounter, size_t domainHash, bool shared) {
+        Key key{IntPair(layerIdx, pos), primarySort, sortCounter, domainHash};
+        if (shared) {
+            auto it = _ids_by_key.find(key);
+            if (it != _ids_by_key.end()) return it->second;
+        }
+        int idx = _records.size();
+        int id = std::numeric_limits<int>::max() - idx;
+        _records[id] = Record{key.origin, primarySort, sortCounter, domainHash, shared ? -1 : idx};
+        if (shared) _ids_by_key[key] = id;
+        return id;
+    }
+
+    void setQSort(int qconst, int qSort) {
+        _q_constants_by_q_sort[qSort] = qconst;
+    }
+
+    bool isQConstant(int id) const {
+        return _records.count(id);
+    }
+    bool isQSort(int id) const {
+        return _q_constants_by_q_sort.count(id);
+    }
+
+    const Record& getRecord(int qconst) const {
+        return _records.at(qconst);
+    }
+    const IntPair& getOrigin(int qconst) const {
+        return _records.at(qconst).origin;
+    }
+
+    size_t size() const {
+        return _records.size();
+    }
+
+    std::string getName(int qconst, const NodeHashMap<int, std::string>& nameBackTable) const {
+        const Record& r = _records.at(qconst);
+        std::stringstream domainHash;
+        domainHash << std::hex << r.domainHash;
+        return "Q_" + std::to_string(r.origin.first) + ","
+            + std::to_string(r.origin.second) + "_" + nameBackTable.at(r.primarySort)
+            + ":" + std::to_string(r.sortCounter)
+            + "_" + domainHash.str()
+            + (r.uniqueIdx < 0 ? std::string() : "_#"+std::to_string(r.uniqueIdx));
+    }
+
+    std::string getQSortName(int qSort, const NodeHashMap<int, std::string>& nameBackTable) const {
+        return "qsort_" + getName(_q_constants_by_q_sort.at(qSort), nameBackTable);
+    }
+};
+
+#endif
@@ -4,8 +4,12 @@
 USignature::USignature() = default;
 USignature::USignature(int nameId, const std::vector<int>& args) : _name_id(nameId), _args(args) {}
 USignature::USignature(int nameId, std::vector<int>&& args) : _name_id(nameId), _args(std::move(args)) {}
-USignature::USignature(const USignature& sig) : _name_id(sig._name_id), _args(sig._args) {}
-USignature::USignature(USignature&& sig) : _name_id(sig._name_id), _args(std::move(sig._args)) {}
+USignature::USignature(const USignature& sig) : _name_id(sig._name_id), _args(sig._args), 
+        _hash(sig._hash.load(std::memory_order_relaxed)) {}
+USignature::USignature(USignature&& sig) : _name_id(sig._name_id), _args(std::move(sig._args)), 
+        _hash(sig._hash.load(std::memory_order_relaxed)) {
+    sig.invalidateHash();
+}
 
 Signature USignature::toSignature(bool negated) const {
     return Signature(*this, negated);
@@ -18,6 +22,7 @@ USignature USignature::substitute(const Substitution& s) const {
 }
 
 void USignature::apply(const Substitution& s) {
+    invalidateHash();
     for (size_t i = 0; i < _args.size(); i++) {
         auto it = s.find(_args[i]);
         if (it != s.end()) _args[i] = it->second;
@@ -28,17 +33,21 @@ void USignature::apply(const Substitution& s) {
 USignature USignature::renamed(int nameId) const {
     USignature sig(*this);
     sig._name_id = nameId;
+    sig.invalidateHash();
     return sig;
 }
 
 USignature& USignature::operator=(const USignature& sig) {
     _name_id = sig._name_id;
     _args = sig._args;
+    _hash.store(sig._hash.load(std::memory_order_relaxed), std::memory_order_relaxed);
     return *this;
 }
 USignature& USignature::operator=(USignature&& sig) {
     _name_id = sig._name_id;
     _args = std::move(sig._args);
+    _hash.store(sig._hash.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    sig.invalidateHash();
     return *this;
 }
 
@@ -86,4 +95,14 @@ Signature& Signature::operator=(Signature&& sig) {
     return *this;
 }
 
+size_t USignature::computeHash() const {
+    size_t hash = USignatureHasher::seed + _args.size();
+    for (const int& arg : _args) {
+        hash_combine(hash, arg);
+    }
+    hash_combine(hash, _name_id);
+    // 0 is reserved for "not computed"
+    return hash == 0 ? 1 : hash;
+}
+
 int USignatureHasher::seed = 1;
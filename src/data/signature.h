@@ -5,6 +5,7 @@
 #include <vector>
 #include <assert.h>
 #include <limits>
+#include <atomic>
 
 #include "util/hashmap.h"
 #include "util/hash.h"
@@ -31,6 +32,12 @@ struct USignature {
     int _name_id = -1;
     std::vector<int> _args;
 
+    // Lazily computed hash value (0: not computed yet).
+    // Any code writing to _name_id or _args directly must call invalidateHash().
+    // Atomic since shared signatures are hashed concurrently by the encoding threads;
+    // relaxed ordering suffices as all threads compute the same value.
+    mutable std::atomic<size_t> _hash = 0;
+
     USignature();
     USignature(int nameId, const std::vector<int>& args);
     USignature(int nameId, std::vector<int>&& args);
@@ -45,8 +52,24 @@ struct USignature {
     USignature& operator=(const USignature& sig);
     USignature& operator=(USignature&& sig);
 
+    inline void invalidateHash() {
+        _hash.store(0, std::memory_order_relaxed);
+    }
+    size_t computeHash() const;
+    inline size_t getHash() const {
+        size_t hash = _hash.load(std::memory_order_relaxed);
+        if (hash == 0) {
+            hash = computeHash();
+            _hash.store(hash, std::memory_order_relaxed);
+        }
+        return hash;
+    }
+
     inline bool operator==(const USignature& b) const {
         if (_name_id != b._name_id) return false;
+        size_t hash = _hash.load(std::memory_order_relaxed);
+        size_t otherHash = b._hash.load(std::memory_order_relaxed);
+        if (hash != 0 && otherHash != 0 && hash != otherHash) return false;
         if (_args != b._args) return false;
         return true;
     }
@@ -99,12 +122,7 @@ struct PositionedUSig {
 struct USignatureHasher {
     static int seed;
     inline std::size_t operator()(const USignature& s) const {
-        size_t hash = seed + s._args.size();
-        for (const int& arg : s._args) {
-            hash_combine(hash, arg);
-        }
-        hash_combine(hash, s._name_id);
-        return hash;
+        return s.getHash();
     }
 };
 struct SignatureHasher {
@@ -1,18 +1,21 @@
 
 #include <assert.h>
+#include <cstring>
 
 #include "substitution.h"
 
-Substitution::Entry::Entry(int first, int second) : first(first), second(second) {}
-Substitution::Entry::Entry(const Entry& other) : first(other.first), second(other.second) {}
+Substitution::Substitution() : _data(_inline) {}
 
-Substitution::Substitution() {}
-
-Substitution::Substitution(const Substitution& other) : _entries(other._entries) {}
-Substitution::Substitution(Substitution&& old) : _entries(std::move(old._entries)) {}
+Substitution::Substitution(const Substitution& other) : _data(_inline) {
+    *this = other;
+}
+Substitution::Substitution(Substitution&& old) : _data(_inline) {
+    moveFrom(old);
+}
 
-Substitution::Substitution(const std::vector<int>& src, const std::vector<int>& dest) {
+Substitution::Substitution(const std::vector<int>& src, const std::vector<int>& dest) : _data(_inline) {
     assert(src.size() == dest.size());
+    if (src.size() > INLINE_CAPACITY) reserve(src.size());
     for (size_t i = 0; i < src.size(); i++) {
         if (src[i] != dest[i]) {
             assert(!count(src[i]) || (*this)[src[i]] == dest[i]);
@@ -21,32 +24,80 @@ Substitution::Substitution(const std::vector<int>& src, const std::vector<int>&
     }
 }
 
+Substitution::~Substitution() {
+    if (!isInline()) delete[] _data;
+}
+
+Substitution& Substitution::operator=(const Substitution& other) {
+    if (this == &other) return *this;
+    _size = 0;
+    reserve(other._size);
+    std::memcpy(_data, other._data, other._size * sizeof(Entry));
+    _size = other._size;
+    return *this;
+}
+
+Substitution& Substitution::operator=(Substitution&& other) {
+    if (this == &other) return *this;
+    if (!isInline()) delete[] _data;
+    _data = _inline;
+    _capacity = INLINE_CAPACITY;
+    moveFrom(other);
+    return *this;
+}
+
+void Substitution::moveFrom(Substitution& old) {
+    if (old.isInline()) {
+        std::memcpy(_inline, old._inline, old._size * sizeof(Entry));
+    } else {
+        // Steal heap storage
+        _data = old._data;
+        _capacity = old._capacity;
+        old._data = old._inline;
+        old._capacity = INLINE_CAPACITY;
+    }
+    _size = old._size;
+    old._size = 0;
+}
+
+void Substitution::reserve(uint32_t capacity) {
+    if (capacity <= _capacity) return;
+    Entry* data = new Entry[capacity];
+    std::memcpy(data, _data, _size * sizeof(Entry));
+    if (!isInline()) delete[] _data;
+    _data = data;
+    _capacity = capacity;
+}
+
+Substitution::Entry& Substitution::insertAt(size_t idx, int key, int val) {
+    if (_size == _capacity) reserve(2*_capacity);
+    std::memmove(_data+idx+1, _data+idx, (_size-idx) * sizeof(Entry));
+    _data[idx] = Entry(key, val);
+    _size++;
+    return _data[idx];
+}
+
 void Substitution::clear() {
-    _entries.clear();
+    _size = 0;
 }
 
 bool Substitution::empty() const {
-    return _entries.empty();
+    return _size == 0;
 }
 
 size_t Substitution::size() const {
-    size_t size = 0;
-    auto it = _entries.begin();
-    while (it != _entries.end()) {++it; size++;}
-    return size;
+    return _size;
 }
 
 Substitution Substitution::concatenate(const Substitution& second) const {
     Substitution s;
     for (const auto& [src, dest] : *this) {
-        if (second.count(dest)) {
-            s[src] = second[dest];
-        } else {
-            s[src] = dest;
-        }
+        auto it = second.find(dest);
+        // Keys of this substitution are visited in sorted order: append
+        s.insertAt(s._size, src, it != second.end() ? it->second : dest);
     }
     for (const auto& [src, dest] : second) {
-        if (!s.count(src)) s[src] = dest;
+        if (!count(src)) s[src] = dest;
     }
     return s;
 }
@@ -63,7 +114,7 @@ std::vector<Substitution> Substitution::getAll(const std::vector<int>& src, cons
             int priorSize = ss.size();
             for (int j = 0; j < priorSize; j++) {
                 Substitution& s = ss[j];
-                
+
                 // Does the substitution already have such a key but with a different value?
                 auto it = s.find(src[i]);
                 if (it != s.end() && it->second != dest[i]) {
@@ -71,7 +122,7 @@ std::vector<Substitution> Substitution::getAll(const std::vector<int>& src, cons
 
                     Substitution s1(s);
                     s1[src[i]] = dest[i];
-                    ss.push_back(s1); // overwritten substitution
+                    ss.push_back(std::move(s1)); // overwritten substitution
 
                 } else {
                     // Just add to substitution
@@ -82,10 +133,3 @@ std::vector<Substitution> Substitution::getAll(const std::vector<int>& src, cons
     }
     return ss;
 }
-
-std::forward_list<Substitution::Entry>::const_iterator Substitution::begin() const {
-    return _entries.begin();
-}
-std::forward_list<Substitution::Entry>::const_iterator Substitution::end() const {
-    return _entries.end();
-}
@@ -3,33 +3,49 @@
 #define DOMPASCH_LILOTANE_SUBSTITUTION_H
 
 #include <vector>
-#include <forward_list>
+#include <algorithm>
+#include <cstdint>
 
 #include "util/hashmap.h"
 #include "util/hash.h"
 
+/*
+A mapping from argument IDs to argument IDs, stored as a contiguous array
+of entries which is kept sorted by key. Up to INLINE_CAPACITY entries are
+held inside the object itself; larger substitutions spill onto the heap.
+Small substitutions are looked up by a linear scan, larger ones by binary search.
+*/
 class Substitution {
 
 public:
-    struct Entry { 
-        int first; 
+    struct Entry {
+        int first;
         int second;
 
-        Entry(int first, int second);
-        Entry(const Entry& other);
+        Entry() = default;
+        Entry(int first, int second) : first(first), second(second) {}
         inline bool operator==(const Entry& other) const {
             return first == other.first && second == other.second;
         }
     };
 
+    typedef const Entry* const_iterator;
+    typedef Entry* iterator;
+
+    static const uint32_t INLINE_CAPACITY = 8;
+
 private:
-    std::forward_list<Entry> _entries;
+    Entry _inline[INLINE_CAPACITY];
+    Entry* _data;
+    uint32_t _size = 0;
+    uint32_t _capacity = INLINE_CAPACITY;
 
 public:
     Substitution();
     Substitution(const Substitution& other);
     Substitution(Substitution&& old);
     Substitution(const std::vector<int>& src, const std::vector<int>& dest);
+    ~Substitution();
 
     void clear();
 
@@ -38,8 +54,8 @@ public:
 
     Substitution concatenate(const Substitution& second) const;
 
-    std::forward_list<Entry>::const_iterator begin() const;
-    std::forward_list<Entry>::const_iterator end() const;
+    inline const_iterator begin() const {return _data;}
+    inline const_iterator end() const {return _data + _size;}
 
     //static Substitution get(const std::vector<int>& src, const std::vector<int>& dest);
     static std::vector<Substitution> getAll(const std::vector<int>& src, const std::vector<int>& dest);
@@ -57,37 +73,9 @@ public:
     };
 
     inline int& operator[](const int& key) {
-
-        auto it = _entries.begin();
-
-        // Empty list?
-        if (it == _entries.end()) {
-            _entries.emplace_front(key, 0);
-            return _entries.begin()->second;
-        }
-
-        // Scan entries
-        auto nextIt = _entries.begin();
-        while (it != _entries.end()) {
-            
-            // Key found: return associated value
-            if (it->first == key) return it->second;
-            
-            // Peek next position
-            ++nextIt;
-
-            // Break if this is the position to insert
-            if (nextIt == _entries.end() || nextIt->first > key) break;
-
-            // Proceed to next position
-            ++it;
-        }
-        
-        // Insert, make iterator point to inserted entry
-        _entries.emplace_after(it, key, 0);
-        ++it;
-
-        return it->second;
+        Entry* it = lowerBound(key);
+        if (it != _data + _size && it->first == key) return it->second;
+        return insertAt(it - _data, key, 0).second;
     }
 
     inline int operator[](const int& key) const {
@@ -95,47 +83,57 @@ public:
     }
 
     inline int at(const int& key) const {
-        auto it = _entries.begin();
-        while (it != _entries.end() && it->first != key) ++it;
-        return it->second;
+        return find(key)->second;
     }
 
-    inline std::forward_list<Substitution::Entry>::const_iterator find(int key) const {
-        auto it = _entries.begin();
-        while (it != _entries.end() && it->first != key) ++it;
-        return it;
+    inline const_iterator find(int key) const {
+        const Entry* it = lowerBound(key);
+        return (it != end() && it->first == key) ? it : end();
     }
 
-    inline std::forward_list<Substitution::Entry>::iterator find(int key) {
-        std::forward_list<Substitution::Entry>::iterator it = _entries.begin();
-        while (it != _entries.end() && it->first != key) ++it;
-        return it;
+    inline iterator find(int key) {
+        Entry* it = lowerBound(key);
+        return (it != _data + _size && it->first == key) ? it : _data + _size;
     }
 
     inline int count(const int& key) const {
-        auto it = _entries.begin();
-        while (it != _entries.end() && it->first != key) ++it;
-        return it != _entries.end();
+        return find(key) != end();
     }
 
-
     inline bool operator==(const Substitution& other) const {
-        return _entries == other._entries;
+        return _size == other._size && std::equal(begin(), end(), other.begin());
     }
 
     inline bool operator!=(const Substitution& other) const {
         return !(*this == other);
     }
 
-    inline void operator=(const Substitution& other) {
-        _entries = other._entries;
-    }
+    Substitution& operator=(const Substitution& other);
+    Substitution& operator=(Substitution&& other);
 
 private:
     inline void add(int key, int val) {
         (*this)[key] = val;
     }
 
+    inline Entry* lowerBound(int key) const {
+        Entry* it = _data;
+        Entry* end = _data + _size;
+        if (_size <= INLINE_CAPACITY) {
+            while (it != end && it->first < key) ++it;
+            return it;
+        }
+        return std::lower_bound(it, end, key, [](const Entry& e, int k) {return e.first < k;});
+    }
+
+    inline bool isInline() const {
+        return _data == _inline;
+    }
+
+    Entry& insertAt(size_t idx, int key, int val);
+    void reserve(uint32_t capacity);
+    void moveFrom(Substitution& old);
+
 };
 
-#endif
\ No newline at end of file
+#endif
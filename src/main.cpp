@@ -97,7 +97,7 @@ int main(int argc, char** argv) {
         exit(0);
     }
 
-    if (params.getProblemFilename() == "") {
+    if (params.getProblemFilename() == "" && !params.isSet("snapshot-in")) {
         Log::w("Please specify both a domain file and a problem file. Use -h for help.\n");
         exit(1);
     }
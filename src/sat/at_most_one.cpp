@@ -0,0 +1,245 @@
+
+#include <assert.h>
+#include <algorithm>
+
+#include "at_most_one.h"
+#include "binary_amo.h"
+#include "variable_domain.h"
+#include "util/log.h"
+
+// Weights of the cost model: an auxiliary variable counts as much as two clauses,
+// and an encoding with weak propagation counts twice as much as its size.
+const double AUX_VAR_WEIGHT = 2;
+const double WEAK_PROPAGATION_WEIGHT = 2;
+
+AtMostOne::Cost AtMostOne::estimate(AmoEncoding encoding, size_t n) {
+    Cost cost;
+    switch (encoding) {
+    case AMO_PAIRWISE:
+        cost.numClauses = n < 2 ? 0 : n*(n-1)/2;
+        break;
+    case AMO_BINARY: {
+        // n+1 states (including "none"), k digits, forbidden representable states in blocks
+        if (n == 0) break;
+        size_t numReprStates = 1;
+        while (numReprStates < n+1) {
+            numReprStates *= 2;
+            cost.numAuxVars++;
+        }
+        cost.numClauses = n * (cost.numAuxVars+1);
+        for (size_t diff = numReprStates - (n+1); diff > 0; diff >>= 1) {
+            if (diff & 0x1) cost.numClauses++;
+        }
+        // A partial assignment to the digits does not rule out any variables early
+        cost.strongPropagation = false;
+        break;
+    }
+    case AMO_LADDER:
+        return LadderAtMostOne::estimate(n);
+    case AMO_COMMANDER:
+        return CommanderAtMostOne::estimate(n);
+    case AMO_PRODUCT:
+        return ProductAtMostOne::estimate(n);
+    default:
+        assert(false);
+    }
+    return cost;
+}
+
+AmoEncoding AtMostOne::select(size_t n) {
+    AmoEncoding best = AMO_PAIRWISE;
+    double bestCost = -1;
+    for (int e = AMO_PAIRWISE; e < NUM_AMO_ENCODINGS; e++) {
+        Cost cost = estimate((AmoEncoding)e, n);
+        double weighted = cost.numClauses + AUX_VAR_WEIGHT * cost.numAuxVars;
+        if (!cost.strongPropagation) weighted *= WEAK_PROPAGATION_WEIGHT;
+        if (bestCost < 0 || weighted < bestCost) {
+            best = (AmoEncoding)e;
+            bestCost = weighted;
+        }
+    }
+    return best;
+}
+
+std::vector<std::vector<int>> AtMostOne::encode(AmoEncoding encoding, const std::vector<int>& vars) {
+    std::vector<std::vector<int>> cls;
+    switch (encoding) {
+    case AMO_PAIRWISE:
+        encodePairwise(vars, cls);
+        return cls;
+    case AMO_BINARY:
+        if (vars.empty()) return cls;
+        return BinaryAtMostOne(vars, vars.size()+1).encode();
+    case AMO_LADDER:
+        return LadderAtMostOne(vars).encode();
+    case AMO_COMMANDER:
+        return CommanderAtMostOne(vars).encode();
+    case AMO_PRODUCT:
+        return ProductAtMostOne(vars).encode();
+    default:
+        assert(false);
+        return cls;
+    }
+}
+
+const char* AtMostOne::getName(AmoEncoding encoding) {
+    switch (encoding) {
+    case AMO_PAIRWISE: return "pairwise";
+    case AMO_BINARY: return "binary";
+    case AMO_LADDER: return "ladder";
+    case AMO_COMMANDER: return "commander";
+    case AMO_PRODUCT: return "product";
+    default: return "?";
+    }
+}
+
+void AtMostOne::encodePairwise(const std::vector<int>& vars, std::vector<std::vector<int>>& cls) {
+    for (size_t i = 0; i < vars.size(); i++) {
+        for (size_t j = i+1; j < vars.size(); j++) {
+            cls.push_back(std::vector<int>{-vars[i], -vars[j]});
+        }
+    }
+}
+
+
+
+std::vector<std::vector<int>> LadderAtMostOne::encode() {
+    std::vector<std::vector<int>> cls;
+    size_t n = _vars.size();
+    if (n <= 1) return cls;
+
+    // s_i <=> OR(x_1, ..., x_i) for i < n (only the "=>" direction is needed)
+    std::vector<int> sums(n-1);
+    for (size_t i = 0; i+1 < n; i++) {
+        sums[i] = VariableDomain::nextVar();
+        Log::d("VARMAP %i (__ladder_%i-%i_%i)\n", sums[i], _vars[0], _vars[n-1], i);
+    }
+
+    cls.push_back(std::vector<int>{-_vars[0], sums[0]});
+    for (size_t i = 1; i+1 < n; i++) {
+        cls.push_back(std::vector<int>{-_vars[i], sums[i]});
+        cls.push_back(std::vector<int>{-sums[i-1], sums[i]});
+        cls.push_back(std::vector<int>{-_vars[i], -sums[i-1]});
+    }
+    cls.push_back(std::vector<int>{-_vars[n-1], -sums[n-2]});
+    return cls;
+}
+
+AtMostOne::Cost LadderAtMostOne::estimate(size_t n) {
+    AtMostOne::Cost cost;
+    if (n <= 1) return cost;
+    cost.numClauses = 3*n-4;
+    cost.numAuxVars = n-1;
+    return cost;
+}
+
+
+
+std::vector<std::vector<int>> CommanderAtMostOne::encode() {
+    std::vector<std::vector<int>> cls;
+    encode(_vars, cls);
+    return cls;
+}
+
+void CommanderAtMostOne::encode(const std::vector<int>& vars, std::vector<std::vector<int>>& cls) {
+
+    // A single group: pairwise
+    if (vars.size() <= GROUP_SIZE+1) {
+        AtMostOne::encodePairwise(vars, cls);
+        return;
+    }
+
+    std::vector<int> commanders;
+    for (size_t start = 0; start < vars.size(); start += GROUP_SIZE) {
+        size_t end = std::min(start+GROUP_SIZE, vars.size());
+        if (end-start == 1) {
+            // A single variable is its own commander
+            commanders.push_back(vars[start]);
+            continue;
+        }
+        int c = VariableDomain::nextVar();
+        Log::d("VARMAP %i (__cmdr_%i-%i)\n", c, vars[start], vars[end-1]);
+        commanders.push_back(c);
+        for (size_t i = start; i < end; i++) {
+            // At most one within the group
+            for (size_t j = i+1; j < end; j++) cls.push_back(std::vector<int>{-vars[i], -vars[j]});
+            // Any variable of the group implies the commander
+            cls.push_back(std::vector<int>{-vars[i], c});
+        }
+    }
+    encode(commanders, cls);
+}
+
+AtMostOne::Cost CommanderAtMostOne::estimate(size_t n) {
+    AtMostOne::Cost cost;
+    while (n > GROUP_SIZE+1) {
+        size_t numGroups = 0;
+        for (size_t start = 0; start < n; start += GROUP_SIZE) {
+            size_t size = std::min(GROUP_SIZE, n-start);
+            numGroups++;
+            if (size == 1) continue;
+            cost.numClauses += size*(size-1)/2 + size;
+            cost.numAuxVars++;
+        }
+        n = numGroups;
+    }
+    cost.numClauses += n < 2 ? 0 : n*(n-1)/2;
+    return cost;
+}
+
+
+
+std::vector<std::vector<int>> ProductAtMostOne::encode() {
+    std::vector<std::vector<int>> cls;
+    encode(_vars, cls);
+    return cls;
+}
+
+void ProductAtMostOne::encode(const std::vector<int>& vars, std::vector<std::vector<int>>& cls) {
+
+    if (vars.size() <= MAX_PAIRWISE_SIZE) {
+        AtMostOne::encodePairwise(vars, cls);
+        return;
+    }
+
+    size_t p, q;
+    getDimensions(vars.size(), p, q);
+    std::vector<int> rows(p), cols(q);
+    for (size_t i = 0; i < p; i++) {
+        rows[i] = VariableDomain::nextVar();
+        Log::d("VARMAP %i (__prod_%i-%i_r%i)\n", rows[i], vars.front(), vars.back(), i);
+    }
+    for (size_t j = 0; j < q; j++) {
+        cols[j] = VariableDomain::nextVar();
+        Log::d("VARMAP %i (__prod_%i-%i_c%i)\n", cols[j], vars.front(), vars.back(), j);
+    }
+
+    // Variable k is at row k mod p and column k div p: distinct cells for distinct variables
+    for (size_t k = 0; k < vars.size(); k++) {
+        cls.push_back(std::vector<int>{-vars[k], rows[k % p]});
+        cls.push_back(std::vector<int>{-vars[k], cols[k / p]});
+    }
+    encode(rows, cls);
+    encode(cols, cls);
+}
+
+AtMostOne::Cost ProductAtMostOne::estimate(size_t n) {
+    AtMostOne::Cost cost;
+    if (n <= MAX_PAIRWISE_SIZE) {
+        cost.numClauses = n < 2 ? 0 : n*(n-1)/2;
+        return cost;
+    }
+    size_t p, q;
+    getDimensions(n, p, q);
+    AtMostOne::Cost rowCost = estimate(p);
+    AtMostOne::Cost colCost = estimate(q);
+    cost.numClauses = 2*n + rowCost.numClauses + colCost.numClauses;
+    cost.numAuxVars = p + q + rowCost.numAuxVars + colCost.numAuxVars;
+    return cost;
+}
+
+void ProductAtMostOne::getDimensions(size_t n, size_t& p, size_t& q) {
+    p = 1;
+    while (p*p < n) p++;
+    q = (n+p-1) / p;
+}
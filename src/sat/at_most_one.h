@@ -0,0 +1,98 @@
+
+#ifndef DOMPASCH_LILOTANE_AT_MOST_ONE_H
+#define DOMPASCH_LILOTANE_AT_MOST_ONE_H
+
+#include <vector>
+#include <cstddef>
+
+// Encodings of an at-most-one constraint. The values correspond to the -amo parameter.
+enum AmoEncoding {
+    AMO_THRESHOLD = -1, // pairwise below the -bamot threshold, binary otherwise
+    AMO_AUTO = 0, // selected per constraint by the cost model
+    AMO_PAIRWISE = 1, AMO_BINARY = 2, AMO_LADDER = 3, AMO_COMMANDER = 4, AMO_PRODUCT = 5
+};
+const int NUM_AMO_ENCODINGS = 6;
+
+/*
+Selection and construction of at-most-one constraints over a set of distinct variables.
+Auxiliary variables are allocated from the VariableDomain.
+*/
+class AtMostOne {
+
+public:
+    struct Cost {
+        size_t numClauses = 0;
+        size_t numAuxVars = 0;
+        // Does unit propagation derive every implied literal on the constraint's variables
+        // as well as on the auxiliary variables?
+        bool strongPropagation = true;
+    };
+
+    // Exact number of clauses and auxiliary variables which the encoding produces for n variables.
+    static Cost estimate(AmoEncoding encoding, size_t n);
+
+    // The encoding with the smallest weighted cost for n variables.
+    static AmoEncoding select(size_t n);
+
+    static std::vector<std::vector<int>> encode(AmoEncoding encoding, const std::vector<int>& vars);
+
+    static const char* getName(AmoEncoding encoding);
+
+    static void encodePairwise(const std::vector<int>& vars, std::vector<std::vector<int>>& cls);
+};
+
+// Sequential counter: s_i is implied by each of x_1, ..., x_i and excludes x_{i+1}.
+// 3n-4 clauses and n-1 auxiliary variables.
+class LadderAtMostOne {
+
+private:
+    std::vector<int> _vars;
+
+public:
+    LadderAtMostOne(const std::vector<int>& vars) : _vars(vars) {}
+    std::vector<std::vector<int>> encode();
+
+    static AtMostOne::Cost estimate(size_t n);
+};
+
+// Groups of three variables with a "commander" variable each, which is implied by any
+// variable of its group; recursively, at most one commander may be true.
+class CommanderAtMostOne {
+
+private:
+    std::vector<int> _vars;
+
+public:
+    static constexpr size_t GROUP_SIZE = 3;
+
+    CommanderAtMostOne(const std::vector<int>& vars) : _vars(vars) {}
+    std::vector<std::vector<int>> encode();
+
+    static AtMostOne::Cost estimate(size_t n);
+
+private:
+    static void encode(const std::vector<int>& vars, std::vector<std::vector<int>>& cls);
+};
+
+// Variables are arranged in a p x q grid (p = ceil(sqrt(n))); each variable implies its row
+// and its column variable, and recursively, at most one row and at most one column is true.
+class ProductAtMostOne {
+
+private:
+    std::vector<int> _vars;
+
+public:
+    // Up to this number of variables, the pairwise encoding is used.
+    static constexpr size_t MAX_PAIRWISE_SIZE = 4;
+
+    ProductAtMostOne(const std::vector<int>& vars) : _vars(vars) {}
+    std::vector<std::vector<int>> encode();
+
+    static AtMostOne::Cost estimate(size_t n);
+
+private:
+    static void encode(const std::vector<int>& vars, std::vector<std::vector<int>>& cls);
+    static void getDimensions(size_t n, size_t& p, size_t& q);
+};
+
+#endif
@@ -55,6 +55,7 @@ public:
 
                 if (_htn.isActionRepetition(aSig._name_id)) {
                     aSig._name_id = _htn.getActionNameFromRepetition(sig._name_id);
+                    aSig.invalidateHash();
                 }
 
                 //log("  %s ?\n", TOSTR(aSig));
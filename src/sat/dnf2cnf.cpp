@@ -0,0 +1,130 @@
+
+#include <algorithm>
+#include <cstdlib>
+#include <assert.h>
+
+#include "dnf2cnf.h"
+#include "variable_domain.h"
+#include "util/log.h"
+
+// An auxiliary variable counts as much as two literals when comparing encoding sizes.
+const size_t AUX_VAR_WEIGHT = 2;
+
+void Dnf2Cnf::normalize(std::vector<std::vector<int>>& dnf) {
+
+    for (auto& term : dnf) {
+        std::sort(term.begin(), term.end());
+        term.erase(std::unique(term.begin(), term.end()), term.end());
+    }
+
+    // Shorter terms first, such that each term can only be subsumed by a preceding term
+    std::sort(dnf.begin(), dnf.end(), [](const std::vector<int>& left, const std::vector<int>& right) {
+        return left.size() < right.size() || (left.size() == right.size() && left < right);
+    });
+    size_t numKept = 0;
+    for (size_t i = 0; i < dnf.size(); i++) {
+        bool subsumed = false;
+        for (size_t j = 0; j < numKept && !subsumed; j++) {
+            subsumed = std::includes(dnf[i].begin(), dnf[i].end(), dnf[j].begin(), dnf[j].end());
+        }
+        if (subsumed) continue;
+        if (numKept != i) dnf[numKept] = std::move(dnf[i]);
+        numKept++;
+    }
+    dnf.resize(numKept);
+}
+
+size_t Dnf2Cnf::getNumDistributedClauses(const std::vector<std::vector<int>>& dnf, size_t limit) {
+    size_t size = 1;
+    for (const auto& term : dnf) {
+        size *= term.size();
+        if (size > limit) return limit+1;
+    }
+    return size;
+}
+
+size_t Dnf2Cnf::getCnf(const std::vector<std::vector<int>>& dnf, const std::vector<int>& prefix,
+        std::vector<int>& cnf, size_t maxDistributedClauses) {
+
+    assert(!dnf.empty());
+
+    size_t numDistributed = getNumDistributedClauses(dnf, maxDistributedClauses);
+    if (numDistributed <= maxDistributedClauses) {
+        // Compare the (maximum) number of literals of both encodings
+        size_t distributedLits = numDistributed * (prefix.size() + dnf.size());
+        size_t tseitinLits = prefix.size() + dnf.size();
+        for (const auto& term : dnf) if (term.size() > 1) tseitinLits += 2*term.size() + AUX_VAR_WEIGHT;
+        if (distributedLits <= tseitinLits) {
+            distribute(dnf, prefix, cnf);
+            return 0;
+        }
+    }
+    return introduceTermVariables(dnf, prefix, cnf);
+}
+
+void Dnf2Cnf::distribute(const std::vector<std::vector<int>>& dnf, const std::vector<int>& prefix, std::vector<int>& cnf) {
+
+    // Pick one literal of each term in all possible ways
+    std::vector<std::vector<int>> clauses;
+    std::vector<size_t> counter(dnf.size(), 0);
+    std::vector<int> cls(dnf.size());
+    while (true) {
+        for (size_t i = 0; i < dnf.size(); i++) cls[i] = dnf[i][counter[i]];
+        clauses.push_back(cls);
+
+        size_t i = 0;
+        while (i < counter.size() && ++counter[i] == dnf[i].size()) counter[i++] = 0;
+        if (i == counter.size()) break;
+    }
+
+    // Remove duplicate literals, tautological and duplicate clauses
+    for (auto& c : clauses) {
+        std::sort(c.begin(), c.end(), [](int left, int right) {
+            return std::abs(left) < std::abs(right) || (std::abs(left) == std::abs(right) && left < right);
+        });
+        c.erase(std::unique(c.begin(), c.end()), c.end());
+        for (size_t i = 0; i+1 < c.size(); i++) if (c[i] == -c[i+1]) {
+            c.clear();
+            break;
+        }
+    }
+    std::sort(clauses.begin(), clauses.end());
+    clauses.erase(std::unique(clauses.begin(), clauses.end()), clauses.end());
+
+    for (const auto& c : clauses) {
+        if (c.empty()) continue;
+        cnf.insert(cnf.end(), prefix.begin(), prefix.end());
+        cnf.insert(cnf.end(), c.begin(), c.end());
+        cnf.push_back(0);
+    }
+}
+
+size_t Dnf2Cnf::introduceTermVariables(const std::vector<std::vector<int>>& dnf, const std::vector<int>& prefix, std::vector<int>& cnf) {
+
+    // Prefix OR some term holds; terms with a single literal are used directly
+    size_t numAuxVars = 0;
+    std::vector<int> termLits(dnf.size());
+    for (size_t i = 0; i < dnf.size(); i++) {
+        if (dnf[i].size() == 1) {
+            termLits[i] = dnf[i][0];
+            continue;
+        }
+        termLits[i] = VariableDomain::nextVar();
+        Log::d("VARMAP %i (__dnfterm_%i_%i)\n", termLits[i], dnf[i][0], i);
+        numAuxVars++;
+    }
+    cnf.insert(cnf.end(), prefix.begin(), prefix.end());
+    cnf.insert(cnf.end(), termLits.begin(), termLits.end());
+    cnf.push_back(0);
+
+    // Each auxiliary variable implies all literals of its term
+    for (size_t i = 0; i < dnf.size(); i++) {
+        if (dnf[i].size() == 1) continue;
+        for (int lit : dnf[i]) {
+            cnf.push_back(-termLits[i]);
+            cnf.push_back(lit);
+            cnf.push_back(0);
+        }
+    }
+    return numAuxVars;
+}
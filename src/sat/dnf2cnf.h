@@ -2,70 +2,39 @@
 #ifndef DOMPASCH_LILOTANE_DNF_2_CNF_H
 #define DOMPASCH_LILOTANE_DNF_2_CNF_H
 
-#include <set>
 #include <vector>
-#include <assert.h>
-
-#include "util/log.h"
-
+#include <cstddef>
+
+/*
+Conversion of a DNF, given as a vector of terms (conjunctions of literals), into clauses.
+Each clause is prefixed with a number of literals, e.g., the negated conditions under which
+the DNF must hold. The distributive law is applied if it results in a small encoding;
+otherwise, each term of several literals is represented by an auxiliary (Tseitin) variable
+which implies the term's literals, resulting in an encoding of linear size.
+*/
 class Dnf2Cnf {
 
 public:
-    static std::set<std::set<int>> getCnf(const std::vector<int>& dnf) {
-        std::set<std::set<int>> cnf;
-
-        if (dnf.empty()) return cnf;
-
-        int size = 1;
-        int clsSize = 0;
-        std::vector<int> clsStarts;
-        for (size_t i = 0; i < dnf.size(); i++) {
-            if (dnf[i] == 0) {
-                size *= clsSize;
-                clsSize = 0;
-            } else {
-                if (clsSize == 0) clsStarts.push_back(i);
-                clsSize++;
-            }
-        }
-        assert(size > 0);
-
-        // Iterate over all possible combinations
-        std::vector<int> counter(clsStarts.size(), 0);
-        while (true) {
-            // Assemble the combination
-            std::set<int> newCls;
-            for (size_t pos = 0; pos < counter.size(); pos++) {
-                const int& lit = dnf[clsStarts[pos]+counter[pos]];
-                assert(lit != 0);
-                newCls.insert(lit);
-            }
-            cnf.insert(newCls);            
-
-            // Increment exponential counter
-            size_t x = 0;
-            while (x < counter.size()) {
-                if (dnf[clsStarts[x]+counter[x]+1] == 0) {
-                    // max value reached
-                    counter[x] = 0;
-                    if (x+1 == counter.size()) break;
-                } else {
-                    // increment
-                    counter[x]++;
-                    break;
-                }
-                x++;
-            }
-
-            // Counter finished?
-            if (counter[x] == 0 && x+1 == counter.size()) break;
-        }
-
-        if (cnf.size() > 1000) Log::w("CNF of size %i generated\n", cnf.size());
-        //else Log::d("CNF of size %i generated\n", cnf.size());
-
-        return cnf;
-    }
+    // Hard limit on the number of clauses generated by the distributive law.
+    static const size_t MAX_DISTRIBUTED_CLAUSES = 256;
+
+    // Sorts the literals of each term and removes duplicate literals
+    // as well as duplicate and subsumed terms.
+    static void normalize(std::vector<std::vector<int>>& dnf);
+
+    // Number of clauses which the distributive law generates at most,
+    // or limit+1 if the number exceeds the limit.
+    static size_t getNumDistributedClauses(const std::vector<std::vector<int>>& dnf, size_t limit);
+
+    // Appends zero-terminated clauses to cnf which are equivalent to (prefix OR dnf),
+    // modulo auxiliary variables. The DNF must be normalized and non-empty.
+    // Returns the number of introduced auxiliary variables.
+    static size_t getCnf(const std::vector<std::vector<int>>& dnf, const std::vector<int>& prefix,
+            std::vector<int>& cnf, size_t maxDistributedClauses = MAX_DISTRIBUTED_CLAUSES);
+
+private:
+    static void distribute(const std::vector<std::vector<int>>& dnf, const std::vector<int>& prefix, std::vector<int>& cnf);
+    static size_t introduceTermVariables(const std::vector<std::vector<int>>& dnf, const std::vector<int>& prefix, std::vector<int>& cnf);
 };
 
 #endif
@@ -2,15 +2,28 @@
 #include <random>
 #include <vector>
 #include <string>
+#include <thread>
+#include <atomic>
+#include <algorithm>
 
 #include "sat/encoding.h"
 #include "sat/literal_tree.h"
-#include "sat/binary_amo.h"
+#include "sat/at_most_one.h"
 #include "sat/dnf2cnf.h"
+#include "sat/support_groups.h"
 #include "sat/variable_provider.h"
 #include "util/log.h"
 #include "util/timer.h"
 
+// Clauses of the position which the current thread encodes in a deferred manner, if any
+static thread_local Encoding::DeferredClauses* currentDeferredClauses = nullptr;
+
+int Encoding::getNumThreads(Parameters& params) {
+    int numThreads = params.getIntParam("et");
+    if (numThreads <= 0) numThreads = std::max(1u, std::thread::hardware_concurrency());
+    return numThreads;
+}
+
 void Encoding::encode(size_t layerIdx, size_t pos) {
     _termination_callback();
 
@@ -18,6 +31,7 @@ void Encoding::encode(size_t layerIdx, size_t pos) {
 
     _layer_idx = layerIdx;
     _pos = pos;
+    _stats.setLayer(layerIdx);
 
     // Calculate relevant environment of the position
     Position NULL_POS;
@@ -44,15 +58,43 @@ void Encoding::encode(size_t layerIdx, size_t pos) {
     // whether to encode it or to reuse the previous variable
     encodeFactVariables(newPos, left, above);
 
+    // Static mutexes among the (new) ground fact variables
+    if (_encode_fact_mutexes) encodeFactMutexes(newPos);
+
     // 2nd pass over all operations: Init substitution vars where necessary,
     // encode precondition constraints and at-{most,least}-one constraints
     encodeOperationConstraints(newPos);
 
-    // Link qfacts to their possible decodings
-    encodeQFactSemantics(newPos);
+    PositionContext ctx;
+    ctx.layerIdx = layerIdx;
+    ctx.pos = pos;
+    ctx.oldPos = _old_pos;
+    ctx.offset = _offset;
+    ctx.newFactVars = std::move(_new_fact_vars);
+    _new_fact_vars.clear();
 
-    // Effects of "old" actions to the left
-    encodeActionEffects(newPos, left);
+    if (defersClauses()) {
+        // Effects of "old" actions to the left (may introduce q-constant equality variables)
+        encodeActionEffects(newPos, left);
+        // Everything else: see encodeDeferredClauses
+        _deferred_positions.push_back(std::move(ctx));
+
+    } else {
+        // Link qfacts to their possible decodings
+        encodeQFactSemantics(newPos, ctx);
+
+        // Effects of "old" actions to the left
+        encodeActionEffects(newPos, left);
+
+        encodeRemainingClauses(newPos, ctx);
+    }
+
+    _stats.endPosition();
+}
+
+void Encoding::encodeRemainingClauses(Position& newPos, const PositionContext& ctx) {
+    static Position NULL_POS;
+    Position& above = ctx.layerIdx > 0 ? _layers[ctx.layerIdx-1]->at(ctx.oldPos) : NULL_POS;
 
     // Type constraints and forbidden substitutions for q-constants
     // and (sets of) q-facts
@@ -63,7 +105,7 @@ void Encoding::encode(size_t layerIdx, size_t pos) {
     encodeSubtaskRelationships(newPos, above);
 
     // choice of axiomatic ops
-    _stats.begin(STAGE_AXIOMATICOPS);
+    beginStage(STAGE_AXIOMATICOPS);
     const USigSet& axiomaticOps = newPos.getAxiomaticOps();
     if (!axiomaticOps.empty()) {
         for (const USignature& op : axiomaticOps) {
@@ -71,9 +113,90 @@ void Encoding::encode(size_t layerIdx, size_t pos) {
         }
         __interfaceSolver__endClause();
     }
-    _stats.end(STAGE_AXIOMATICOPS);
+    endStage(STAGE_AXIOMATICOPS);
+}
+
+void Encoding::encodeDeferredClauses() {
+
+    if (_deferred_positions.empty()) return;
+    float time = Timer::elapsedSeconds();
+
+    // Generate the clauses of all positions in parallel: Each thread
+    // takes the next position and writes its clauses into the position's buffer
+    std::atomic_size_t nextPosition(0);
+    auto work = [&]() {
+        size_t i;
+        while ((i = nextPosition++) < _deferred_positions.size()) {
+            PositionContext& ctx = _deferred_positions[i];
+            currentDeferredClauses = &ctx.clauses;
+            Position& newPos = _layers[ctx.layerIdx]->at(ctx.pos);
+            encodeQFactSemantics(newPos, ctx);
+            encodeRemainingClauses(newPos, ctx);
+            currentDeferredClauses = nullptr;
+        }
+    };
+    size_t numThreads = std::min((size_t)_num_threads, _deferred_positions.size());
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < numThreads; t++) threads.emplace_back(work);
+    work();
+    for (auto& thread : threads) thread.join();
+
+    // Append all clauses in position order, allocating new variables as they occur
+    for (auto& ctx : _deferred_positions) {
+        _stats.setLayer(ctx.layerIdx);
+        appendDeferredClauses(ctx.clauses);
+    }
 
-    _stats.endPosition();
+    Log::v("Encoded deferred clauses of %i positions with %i threads (%.4fs)\n", 
+        _deferred_positions.size(), numThreads, Timer::elapsedSeconds() - time);
+    _deferred_positions.clear();
+}
+
+void Encoding::appendDeferredClauses(DeferredClauses& clauses) {
+
+    std::vector<int> newVars(clauses.newVars.size());
+    for (size_t i = 0; i < newVars.size(); i++) {
+        const auto& [isEquality, args] = clauses.newVars[i];
+        newVars[i] = isEquality ? encodeQConstEquality(args.first, args.second) 
+                : __interfaceSolver__varSubstitution(args.first, args.second);
+    }
+
+    size_t event = 0;
+    for (size_t i = 0; i < clauses.lits.size(); i++) {
+        while (event < clauses.stageEvents.size() && std::get<0>(clauses.stageEvents[event]) <= i) {
+            const auto& [idx, stage, isBegin, time] = clauses.stageEvents[event++];
+            if (isBegin) _stats.begin(stage, time);
+            else _stats.end(stage, time);
+        }
+        int lit = clauses.lits[i];
+        if (lit == 0) {
+            __interfaceSolver__endClause();
+            continue;
+        }
+        if (std::abs(lit) >= DEFERRED_VAR_OFFSET) {
+            int var = newVars[std::abs(lit) - DEFERRED_VAR_OFFSET];
+            lit = lit > 0 ? var : -var;
+        }
+        __interfaceSolver__appendClause(lit);
+    }
+    while (event < clauses.stageEvents.size()) {
+        const auto& [idx, stage, isBegin, time] = clauses.stageEvents[event++];
+        if (isBegin) _stats.begin(stage, time);
+        else _stats.end(stage, time);
+    }
+    clauses = DeferredClauses();
+}
+
+void Encoding::beginStage(int stage) {
+    if (currentDeferredClauses != nullptr) {
+        currentDeferredClauses->stageEvents.emplace_back(currentDeferredClauses->lits.size(), stage, true, EncodingStatistics::now());
+    } else _stats.begin(stage);
+}
+
+void Encoding::endStage(int stage) {
+    if (currentDeferredClauses != nullptr) {
+        currentDeferredClauses->stageEvents.emplace_back(currentDeferredClauses->lits.size(), stage, false, EncodingStatistics::now());
+    } else _stats.end(stage);
 }
 
 void Encoding::encodeOperationVariables(Position& newPos) {
@@ -81,7 +204,7 @@ void Encoding::encodeOperationVariables(Position& newPos) {
     _primitive_ops.clear();
     _nonprimitive_ops.clear();
 
-    _stats.begin(STAGE_ACTIONCONSTRAINTS);
+    beginStage(STAGE_ACTIONCONSTRAINTS);
     for (const auto& aSig : newPos.getActions()) {
         // int aVar = _vars.encodeVariable(VarType::OP, newPos, aSig);
         int aVar = __interfaceSolver__encodeVariable(VarType::OP, newPos, aSig);(VarType::OP, newPos, aSig);
@@ -89,9 +212,9 @@ void Encoding::encodeOperationVariables(Position& newPos) {
         // If the action occurs, the position is primitive
         _primitive_ops.push_back(aVar);
     }
-    _stats.end(STAGE_ACTIONCONSTRAINTS);
+    endStage(STAGE_ACTIONCONSTRAINTS);
 
-    _stats.begin(STAGE_REDUCTIONCONSTRAINTS);
+    beginStage(STAGE_REDUCTIONCONSTRAINTS);
     for (const auto& rSig : newPos.getReductions()) {
         // int rVar = _vars.(VarType::OP, newPos, rSig);
         int rVar = __interfaceSolver__encodeVariable(VarType::OP, newPos, rSig);
@@ -105,7 +228,7 @@ void Encoding::encodeOperationVariables(Position& newPos) {
             _nonprimitive_ops.push_back(rVar);
         }
     }
-    _stats.end(STAGE_REDUCTIONCONSTRAINTS);
+    endStage(STAGE_REDUCTIONCONSTRAINTS);
 
     newPos.setHasPrimitiveOps(!_primitive_ops.empty());
     newPos.setHasNonprimitiveOps(!_nonprimitive_ops.empty());
@@ -123,25 +246,25 @@ void Encoding::encodeOperationVariables(Position& newPos) {
     // int varPrim = _vars.encodeVarPrimitive(newPos.getLayerIndex(), newPos.getPositionIndex());
     int varPrim = __interfaceSolver__encodeVarPrimitive(newPos.getLayerIndex(), newPos.getPositionIndex());
 
-    _stats.begin(STAGE_REDUCTIONCONSTRAINTS);
+    beginStage(STAGE_REDUCTIONCONSTRAINTS);
     if (_primitive_ops.empty()) {
         // Only non-primitive ops here
         __interfaceSolver__addClause(-varPrim);
     } else {
         // Mix of primitive and non-primitive ops (default)
-        _stats.begin(STAGE_ACTIONCONSTRAINTS);
+        beginStage(STAGE_ACTIONCONSTRAINTS);
         for (int aVar : _primitive_ops) __interfaceSolver__addClause(-aVar, varPrim);
-        _stats.end(STAGE_ACTIONCONSTRAINTS);
+        endStage(STAGE_ACTIONCONSTRAINTS);
         for (int rVar : _nonprimitive_ops) __interfaceSolver__addClause(-rVar, -varPrim);
     }
-    _stats.end(STAGE_REDUCTIONCONSTRAINTS);
+    endStage(STAGE_REDUCTIONCONSTRAINTS);
 }
 
 void Encoding::encodeFactVariables(Position& newPos, Position& left, Position& above) {
 
     _new_fact_vars.clear();
 
-    _stats.begin(STAGE_FACTVARENCODING);
+    beginStage(STAGE_FACTVARENCODING);
 
     // Reuse ground fact variables from above position
     if (newPos.getLayerIndex() > 0 && _offset == 0) {
@@ -209,10 +332,10 @@ void Encoding::encodeFactVariables(Position& newPos, Position& left, Position& a
         }
     }
 
-    _stats.end(STAGE_FACTVARENCODING);
+    endStage(STAGE_FACTVARENCODING);
 
     // Facts that must hold at this position
-    _stats.begin(STAGE_TRUEFACTS);
+    beginStage(STAGE_TRUEFACTS);
     const USigSet* cHere[] = {&newPos.getTrueFacts(), &newPos.getFalseFacts()}; 
     for (int i = 0; i < 2; i++) 
     for (const USignature& factSig : *cHere[i]) if (_analysis.isRelevant(factSig)) {
@@ -226,7 +349,38 @@ void Encoding::encodeFactVariables(Position& newPos, Position& left, Position& a
         }
         Log::d("(%i,%i) DEFFACT %s\n", _layer_idx, _pos, TOSTR(factSig));
     }
-    _stats.end(STAGE_TRUEFACTS);
+    endStage(STAGE_TRUEFACTS);
+}
+
+void Encoding::encodeFactMutexes(Position& newPos) {
+
+    if (_new_fact_vars.empty() || !_analysis.getMutexes().isComputed()) return;
+    const MutexAnalysis& mutexes = _analysis.getMutexes();
+
+    beginStage(STAGE_FACTMUTEXES);
+
+    // Collect the fact variables of each mutex group
+    NodeHashMap<USignature, std::vector<int>, USignatureHasher> varsPerGroup;
+    std::vector<USignature> groups;
+    for (const auto& [factSig, factVar] : newPos.getVariableTable(VarType::FACT)) {
+        if (!mutexes.hasInvariant(factSig._name_id) || _htn.hasQConstants(factSig)) continue;
+        groups.clear();
+        mutexes.getGroups(factSig, groups);
+        for (const USignature& group : groups) varsPerGroup[group].push_back(factVar);
+    }
+
+    // Pairwise exclusion, unless both variables were already constrained before
+    for (const auto& [group, vars] : varsPerGroup) {
+        for (size_t i = 0; i < vars.size(); i++) {
+            for (size_t j = i+1; j < vars.size(); j++) {
+                if (vars[i] == vars[j]) continue;
+                if (!_new_fact_vars.count(vars[i]) && !_new_fact_vars.count(vars[j])) continue;
+                __interfaceSolver__addClause(-vars[i], -vars[j]);
+            }
+        }
+    }
+
+    endStage(STAGE_FACTMUTEXES);
 }
 
 void Encoding::encodeFrameAxioms(Position& newPos, Position& left) {
@@ -234,7 +388,7 @@ void Encoding::encodeFrameAxioms(Position& newPos, Position& left) {
 
     using Supports = const NodeHashMap<USignature, USigSet, USignatureHasher>;
 
-    _stats.begin(STAGE_DIRECTFRAMEAXIOMS);
+    beginStage(STAGE_DIRECTFRAMEAXIOMS);
 
     bool nonprimFactSupport = _params.isNonzero("nps");
     bool hasPrimitiveOps = left.hasPrimitiveOps();
@@ -255,6 +409,10 @@ void Encoding::encodeFrameAxioms(Position& newPos, Position& left) {
     Supports* supp[2] = {&newPos.getNegFactSupports(), &newPos.getPosFactSupports()};
     IndirectFactSupportMap* iSupp[2] = {&newPos.getNegIndirectFactSupports(), &newPos.getPosIndirectFactSupports()};
 
+    // Support sets occurring in several frame axioms may be replaced by an auxiliary variable
+    SupportGroups supportGroups(_use_support_groups);
+    std::vector<int> cnf;
+
     // Find and encode frame axioms for each applicable fact from the left
     size_t skipped = 0;
     for ([[maybe_unused]] const auto& [fact, var] : left.getVariableTable(VarType::FACT)) {
@@ -314,6 +472,7 @@ void Encoding::encodeFrameAxioms(Position& newPos, Position& left) {
         for (int sign = -1; sign <= 1; sign += 2) {
             i++;
             std::vector<int> cls;
+            std::vector<int> supporters;
             // Fact change:
             if (oldFactVars[i] != 0) cls.push_back(oldFactVars[i]);
             cls.push_back(-sign*factVar);
@@ -348,16 +507,24 @@ void Encoding::encodeFrameAxioms(Position& newPos, Position& left) {
                 // DIRECT support
                 if (dir[i] != nullptr) for (const USignature& opSig : *dir[i]) {
                     int opVar = left.getVariableOrZero(VarType::OP, opSig);
-                    if (opVar != 0) cls.push_back(opVar);
+                    if (opVar != 0) supporters.push_back(opVar);
                     USignature virt = opSig.renamed(_htn.getRepetitionNameOfAction(opSig._name_id));
                     int virtOpVar = left.getVariableOrZero(VarType::OP, virt);
-                    if (virtOpVar != 0) cls.push_back(virtOpVar);
+                    if (virtOpVar != 0) supporters.push_back(virtOpVar);
                 }
             }
-            __interfaceSolver__addClause(cls);
+            supportGroups.add(std::move(cls), std::move(supporters), cnf);
         }
     }
-    _stats.end(STAGE_DIRECTFRAMEAXIOMS);
+
+    int firstAuxVar = VariableDomain::getMaxVar()+1;
+    supportGroups.encode(cnf);
+    __interfaceSolver__registerAuxVars(firstAuxVar, "__supp_" + std::to_string(layerIdx) + "_" + std::to_string(pos));
+    for (int lit : cnf) {
+        if (lit == 0) __interfaceSolver__endClause();
+        else __interfaceSolver__appendClause(lit);
+    }
+    endStage(STAGE_DIRECTFRAMEAXIOMS);
 
     Log::d("Skipped %i frame axioms\n", skipped);
 }
@@ -367,7 +534,7 @@ void Encoding::encodeIndirectFrameAxioms(const std::vector<int>& headerLits, int
     // Unconditional effect?
     if (tree.containsEmpty()) return;
 
-    _stats.begin(STAGE_INDIRECTFRAMEAXIOMS);
+    beginStage(STAGE_INDIRECTFRAMEAXIOMS);
             
     // Transform header and tree into a set of clauses
     for (const auto& cls : tree.encode()) {
@@ -379,7 +546,7 @@ void Encoding::encodeIndirectFrameAxioms(const std::vector<int>& headerLits, int
         __interfaceSolver__endClause();
     }
     
-    _stats.end(STAGE_INDIRECTFRAMEAXIOMS);
+    endStage(STAGE_INDIRECTFRAMEAXIOMS);
 }
 
 void Encoding::encodeOperationConstraints(Position& newPos) {
@@ -391,7 +558,7 @@ void Encoding::encodeOperationConstraints(Position& newPos) {
     std::vector<int> elementVars(newPos.getActions().size() + newPos.getReductions().size(), 0);
     int numOccurringOps = 0;
 
-    _stats.begin(STAGE_ACTIONCONSTRAINTS);
+    beginStage(STAGE_ACTIONCONSTRAINTS);
     for (const auto& aSig : newPos.getActions()) {
 
         int aVar = _vars.getVariable(VarType::OP, newPos, aSig);
@@ -407,8 +574,8 @@ void Encoding::encodeOperationConstraints(Position& newPos) {
             __interfaceSolver__addClause(-aVar, (pre._negated?-1:1)*_vars.getVariable(VarType::FACT, newPos, pre._usig));
         }
     }
-    _stats.end(STAGE_ACTIONCONSTRAINTS);
-    _stats.begin(STAGE_REDUCTIONCONSTRAINTS);
+    endStage(STAGE_ACTIONCONSTRAINTS);
+    beginStage(STAGE_REDUCTIONCONSTRAINTS);
     for (const auto& rSig : newPos.getReductions()) {
 
         int rVar = _vars.getVariable(VarType::OP, newPos, rSig);
@@ -421,31 +588,40 @@ void Encoding::encodeOperationConstraints(Position& newPos) {
             __interfaceSolver__addClause(-rVar, (pre._negated?-1:1)*_vars.getVariable(VarType::FACT, newPos, pre._usig));
         }
     }
-    _stats.end(STAGE_REDUCTIONCONSTRAINTS);
+    endStage(STAGE_REDUCTIONCONSTRAINTS);
 
     _q_constants.insert(_new_q_constants.begin(), _new_q_constants.end());
     _new_q_constants.clear();
     
     if (numOccurringOps == 0) return;
 
-    if ((int)elementVars.size() >= _params.getIntParam("bamot")) {
-        // Binary at-most-one
+    beginStage(STAGE_ATMOSTONEELEMENT);
+    encodeAtMostOne(elementVars, STAGE_ATMOSTONEELEMENT);
+    endStage(STAGE_ATMOSTONEELEMENT);
+}
 
-        _stats.begin(STAGE_ATMOSTONEELEMENT);
-        auto bamo = BinaryAtMostOne(elementVars, elementVars.size()+1);
-        for (const auto& c : bamo.encode()) __interfaceSolver__addClause(c);
-        _stats.end(STAGE_ATMOSTONEELEMENT);
+void Encoding::encodeAtMostOne(const std::vector<int>& vars, int stage) {
 
-    } else {
-        // Naive at-most-one
+    AmoEncoding encoding = (AmoEncoding)_amo_encoding;
+    if (encoding == AMO_THRESHOLD) {
+        encoding = (int)vars.size() >= _params.getIntParam("bamot") ? AMO_BINARY : AMO_PAIRWISE;
+    } else if (encoding == AMO_AUTO) {
+        encoding = AtMostOne::select(vars.size());
+    }
+    _stats.countAtMostOne(stage, encoding);
 
-        _stats.begin(STAGE_ATMOSTONEELEMENT);
-        for (size_t i = 0; i < elementVars.size(); i++) {
-            for (size_t j = i+1; j < elementVars.size(); j++) {
-                __interfaceSolver__addClause(-elementVars[i], -elementVars[j]);
+    if (encoding == AMO_PAIRWISE) {
+        // Naive at-most-one
+        for (size_t i = 0; i < vars.size(); i++) {
+            for (size_t j = i+1; j < vars.size(); j++) {
+                __interfaceSolver__addClause(-vars[i], -vars[j]);
             }
         }
-        _stats.end(STAGE_ATMOSTONEELEMENT);
+    } else {
+        int firstAuxVar = VariableDomain::getMaxVar()+1;
+        auto cls = AtMostOne::encode(encoding, vars);
+        __interfaceSolver__registerAuxVars(firstAuxVar, "__AMO");
+        for (const auto& c : cls) __interfaceSolver__addClause(c);
     }
 }
 
@@ -456,6 +632,7 @@ void Encoding::encodeSubstitutionVars(const USignature& opSig, int opVar, int ar
 
     // arg is a *new* q-constant: initialize substitution logic
     _new_q_constants.insert(arg);
+    beginStage(STAGE_INITSUBSTITUTIONS);
 
     std::vector<int> substitutionVars;
     //Log::d("INITSUBVARS @(%i,%i) %s:%s [ ", pos.getLayerIndex(), pos.getPositionIndex(), TOSTR(opSig), TOSTR(arg));
@@ -478,24 +655,14 @@ void Encoding::encodeSubstitutionVars(const USignature& opSig, int opVar, int ar
     __interfaceSolver__endClause();
 
     // AT MOST ONE substitution
-    if ((int)substitutionVars.size() >= _params.getIntParam("bamot")) {
-        // Binary at-most-one
-        auto bamo = BinaryAtMostOne(substitutionVars, substitutionVars.size()+1);
-        for (const auto& c : bamo.encode()) __interfaceSolver__addClause(c);
-    } else {
-        // Naive at-most-one
-        for (int vSub1 : substitutionVars) {
-            for (int vSub2 : substitutionVars) {
-                if (vSub1 < vSub2) __interfaceSolver__addClause(-vSub1, -vSub2);
-            }
-        }
-    }
+    encodeAtMostOne(substitutionVars, STAGE_INITSUBSTITUTIONS);
+    endStage(STAGE_INITSUBSTITUTIONS);
 }
 
-void Encoding::encodeQFactSemantics(Position& newPos) {
+void Encoding::encodeQFactSemantics(Position& newPos, const PositionContext& ctx) {
     static Position NULL_POS;
 
-    _stats.begin(STAGE_QFACTSEMANTICS);
+    beginStage(STAGE_QFACTSEMANTICS);
     std::vector<int> substitutionVars; substitutionVars.reserve(128);
     for (const auto& qfactSig : newPos.getQFacts()) {
         assert(_htn.hasQConstants(qfactSig));
@@ -508,9 +675,9 @@ void Encoding::encodeQFactSemantics(Position& newPos) {
                 continue;
 
             bool filterAbove = false;
-            Position& above = _offset == 0 && _layer_idx > 0 ? _layers[_layer_idx-1]->at(_old_pos) : NULL_POS;
-            if (!_new_fact_vars.count(qfactVar)) {
-                if (_offset == 0 && _layer_idx > 0 && above.getVariableOrZero(VarType::FACT, qfactSig) == qfactVar
+            Position& above = ctx.offset == 0 && ctx.layerIdx > 0 ? _layers[ctx.layerIdx-1]->at(ctx.oldPos) : NULL_POS;
+            if (!ctx.newFactVars.count(qfactVar)) {
+                if (ctx.offset == 0 && ctx.layerIdx > 0 && above.getVariableOrZero(VarType::FACT, qfactSig) == qfactVar
                                 && above.hasQFactDecodings(qfactSig, negated)) {
                     filterAbove = true;
 
@@ -523,8 +690,8 @@ void Encoding::encodeQFactSemantics(Position& newPos) {
                     */
 
                 }
-                if (!filterAbove && _pos > 0) {
-                    Position& left = _layers[_layer_idx]->at(_pos-1);
+                if (!filterAbove && ctx.pos > 0) {
+                    Position& left = _layers[ctx.layerIdx]->at(ctx.pos-1);
                     if (left.getVariableOrZero(VarType::FACT, qfactSig) == qfactVar)
                         continue;
                 }
@@ -548,7 +715,7 @@ void Encoding::encodeQFactSemantics(Position& newPos) {
                 
                 // If the substitution is chosen,
                 // the q-fact and the corresponding actual fact are equivalent
-                //Log::v("QFACTSEM (%i,%i) %s -> %s\n", _layer_idx, _pos, TOSTR(qfactSig), TOSTR(decFactSig));
+                //Log::v("QFACTSEM (%i,%i) %s -> %s\n", ctx.layerIdx, ctx.pos, TOSTR(qfactSig), TOSTR(decFactSig));
                 for (const int& varSubst : substitutionVars) {
                     __interfaceSolver__appendClause(-varSubst);
                 }
@@ -558,13 +725,14 @@ void Encoding::encodeQFactSemantics(Position& newPos) {
             }
         }
     }
-    _stats.end(STAGE_QFACTSEMANTICS);
+    endStage(STAGE_QFACTSEMANTICS);
 }
 
 void Encoding::encodeActionEffects(Position& newPos, Position& left) {
 
     bool treeConversion = _params.isNonzero("tc");
-    _stats.begin(STAGE_ACTIONEFFECTS);
+    std::vector<int> cnf;
+    beginStage(STAGE_ACTIONEFFECTS);
     for (const auto& aSig : left.getActions()) {
         if (_htn.isActionRepetition(aSig._name_id)) continue;
         int aVar = _vars.getVariable(VarType::OP, left, aSig);
@@ -574,7 +742,7 @@ void Encoding::encodeActionEffects(Position& newPos, Position& left) {
         for (const Signature& eff : effects) {
             if (!_vars.isEncoded(VarType::FACT, _layer_idx, _pos, eff._usig)) continue;
 
-            std::set<std::set<int>> unifiersDnf;
+            std::vector<std::vector<int>> unifiersDnf;
             bool unifiedUnconditionally = false;
             if (eff._negated) {
                 for (const auto& posEff : effects) {
@@ -583,7 +751,7 @@ void Encoding::encodeActionEffects(Position& newPos, Position& left) {
                     if (!_vars.isEncoded(VarType::FACT, _layer_idx, _pos, posEff._usig)) continue;
 
                     bool fits = true;
-                    std::set<int> s;
+                    std::vector<int> s;
                     for (size_t i = 0; i < eff._usig._args.size(); i++) {
                         const int& effArg = eff._usig._args[i];
                         const int& posEffArg = posEff._usig._args[i];
@@ -591,15 +759,15 @@ void Encoding::encodeActionEffects(Position& newPos, Position& left) {
                             bool effIsQ = _q_constants.count(effArg);
                             bool posEffIsQ = _q_constants.count(posEffArg);
                             if (effIsQ && posEffIsQ) {
-                                s.insert(encodeQConstEquality(effArg, posEffArg));
+                                s.push_back(encodeQConstEquality(effArg, posEffArg));
                             } else if (effIsQ) {
                                 if (!_htn.getDomainOfQConstant(effArg).count(posEffArg)) fits = false;
                                 // else s.insert(_vars.varSubstitution(effArg, posEffArg));
-                                else s.insert(__interfaceSolver__varSubstitution(effArg, posEffArg));
+                                else s.push_back(__interfaceSolver__varSubstitution(effArg, posEffArg));
                             } else if (posEffIsQ) {
                                 if (!_htn.getDomainOfQConstant(posEffArg).count(effArg)) fits = false;
                                 // else s.insert(_vars.varSubstitution(posEffArg, effArg));
-                                else s.insert(__interfaceSolver__varSubstitution(posEffArg, effArg));
+                                else s.push_back(__interfaceSolver__varSubstitution(posEffArg, effArg));
                             } else fits = false;
                         }
                     }
@@ -608,7 +776,7 @@ void Encoding::encodeActionEffects(Position& newPos, Position& left) {
                         unifiedUnconditionally = true;
                         break;
                     }
-                    if (fits) unifiersDnf.insert(s);
+                    if (fits) unifiersDnf.push_back(std::move(s));
                 }
             }
             if (unifiedUnconditionally) continue; // Always unified
@@ -619,35 +787,34 @@ void Encoding::encodeActionEffects(Position& newPos, Position& left) {
             }
 
             // Negative effect which only holds in certain cases
+            Dnf2Cnf::normalize(unifiersDnf);
             if (treeConversion) {
                 LiteralTree<int> tree;
-                for (const auto& set : unifiersDnf) tree.insert(std::vector<int>(set.begin(), set.end()));
+                for (const auto& term : unifiersDnf) tree.insert(term);
                 std::vector<int> headerLits;
                 headerLits.push_back(aVar);
                 headerLits.push_back(_vars.getVariable(VarType::FACT, newPos, eff._usig));
                 for (const auto& cls : tree.encode(headerLits)) __interfaceSolver__addClause(cls);
             } else {
-                std::vector<int> dnf;
-                for (const auto& set : unifiersDnf) {
-                    for (int lit : set) dnf.push_back(lit);
-                    dnf.push_back(0);
-                }
-                auto cnf = Dnf2Cnf::getCnf(dnf);
-                for (const auto& clause : cnf) {
-                    __interfaceSolver__appendClause(-aVar, -_vars.getVariable(VarType::FACT, newPos, eff._usig));
-                    for (int lit : clause) __interfaceSolver__appendClause(lit);
-                    __interfaceSolver__endClause();
+                std::vector<int> prefix {-aVar, -_vars.getVariable(VarType::FACT, newPos, eff._usig)};
+                cnf.clear();
+                int firstAuxVar = VariableDomain::getMaxVar()+1;
+                Dnf2Cnf::getCnf(unifiersDnf, prefix, cnf);
+                __interfaceSolver__registerAuxVars(firstAuxVar, "__dnfterm");
+                for (int lit : cnf) {
+                    if (lit == 0) __interfaceSolver__endClause();
+                    else __interfaceSolver__appendClause(lit);
                 }
             }
         }
     }
-    _stats.end(STAGE_ACTIONEFFECTS);
+    endStage(STAGE_ACTIONEFFECTS);
 }
 
 void Encoding::encodeQConstraints(Position& newPos) {
 
     // Q-constants type constraints
-    _stats.begin(STAGE_QTYPECONSTRAINTS);
+    beginStage(STAGE_QTYPECONSTRAINTS);
     const auto& constraints = newPos.getQConstantsTypeConstraints();
     for (const auto& [opSig, constraints] : constraints) {
         int opVar = newPos.getVariableOrZero(VarType::OP, opSig);
@@ -673,10 +840,10 @@ void Encoding::encodeQConstraints(Position& newPos) {
             }
         }
     }
-    _stats.end(STAGE_QTYPECONSTRAINTS);
+    endStage(STAGE_QTYPECONSTRAINTS);
 
     // Forbidden substitutions
-    _stats.begin(STAGE_SUBSTITUTIONCONSTRAINTS);
+    beginStage(STAGE_SUBSTITUTIONCONSTRAINTS);
 
     // For each operation (action or reduction)
     const USigSet* ops[2] = {&newPos.getActions(), &newPos.getReductions()};
@@ -707,7 +874,7 @@ void Encoding::encodeQConstraints(Position& newPos) {
     }
     newPos.clearSubstitutions();
     
-    _stats.end(STAGE_SUBSTITUTIONCONSTRAINTS);
+    endStage(STAGE_SUBSTITUTIONCONSTRAINTS);
 }
 
 void Encoding::encodeSubtaskRelationships(Position& newPos, Position& above) {
@@ -720,7 +887,7 @@ void Encoding::encodeSubtaskRelationships(Position& newPos, Position& above) {
     }
 
     // expansions
-    _stats.begin(STAGE_EXPANSIONS);
+    beginStage(STAGE_EXPANSIONS);
     for (const auto& [parent, children] : newPos.getExpansions()) {
 
         int parentVar = _vars.getVariable(VarType::OP, above, parent);
@@ -752,11 +919,11 @@ void Encoding::encodeSubtaskRelationships(Position& newPos, Position& above) {
             }
         }
     }
-    _stats.end(STAGE_EXPANSIONS);
+    endStage(STAGE_EXPANSIONS);
 
     // predecessors
     if (_params.isNonzero("p")) {
-        _stats.begin(STAGE_PREDECESSORS);
+        beginStage(STAGE_PREDECESSORS);
         for (const auto& [child, parents] : newPos.getPredecessors()) {
 
             __interfaceSolver__appendClause(-_vars.getVariable(VarType::OP, newPos, child));
@@ -765,15 +932,24 @@ void Encoding::encodeSubtaskRelationships(Position& newPos, Position& above) {
             }
             __interfaceSolver__endClause();
         }
-        _stats.end(STAGE_PREDECESSORS);
+        endStage(STAGE_PREDECESSORS);
     }
 }
 
 int Encoding::encodeQConstEquality(int q1, int q2) {
 
+    if (currentDeferredClauses != nullptr) {
+        // Variable may only be allocated when appending the deferred clauses
+        int var = _vars.getQConstantEqualityVarOrZero(q1, q2);
+        if (var != 0) return var;
+        auto [it, inserted] = currentDeferredClauses->newEqualityVars.emplace(IntPair(q1, q2), currentDeferredClauses->newVars.size());
+        if (inserted) currentDeferredClauses->newVars.emplace_back(true, IntPair(q1, q2));
+        return DEFERRED_VAR_OFFSET + it->second;
+    }
+
     if (!_vars.isQConstantEqualityEncoded(q1, q2)) {
         
-        _stats.begin(STAGE_QCONSTEQUALITY);
+        beginStage(STAGE_QCONSTEQUALITY);
         FlatHashSet<int> good, bad1, bad2;
         for (int c : _htn.getDomainOfQConstant(q1)) {
             if (!_htn.getDomainOfQConstant(q2).count(c)) bad1.insert(c);
@@ -801,7 +977,7 @@ int Encoding::encodeQConstEquality(int q1, int q2) {
             for (int c : bad1) __interfaceSolver__addClause(-__interfaceSolver__varSubstitution(q1, c), -varEq);
             for (int c : bad2) __interfaceSolver__addClause(-__interfaceSolver__varSubstitution(q2, c), -varEq);
         }
-        _stats.end(STAGE_QCONSTEQUALITY);
+        endStage(STAGE_QCONSTEQUALITY);
     }
     return _vars.getQConstantEqualityVar(q1, q2);
 }
@@ -809,22 +985,22 @@ int Encoding::encodeQConstEquality(int q1, int q2) {
 void Encoding::addAssumptions(int layerIdx, bool permanent) {
     Layer& l = *_layers.at(layerIdx);
     if (_implicit_primitiveness) {
-        _stats.begin(STAGE_ACTIONCONSTRAINTS);
+        beginStage(STAGE_ACTIONCONSTRAINTS);
         for (size_t pos = 0; pos < l.size(); pos++) {
             __interfaceSolver__appendClause(-__interfaceSolver__encodeVarPrimitive(layerIdx, pos));
             for (int var : _primitive_ops) __interfaceSolver__appendClause(var);
             __interfaceSolver__endClause();
         }
-        _stats.end(STAGE_ACTIONCONSTRAINTS);
+        endStage(STAGE_ACTIONCONSTRAINTS);
     }
     for (size_t pos = 0; pos < l.size(); pos++) {
-        _stats.begin(STAGE_ASSUMPTIONS);
+        beginStage(STAGE_ASSUMPTIONS);
         int v = _vars.getVarPrimitiveOrZero(layerIdx, pos);
         if (v != 0) {
             if (permanent) __interfaceSolver__addClause(v);
             else __interfaceSolver__assume(v);
         }
-        _stats.end(STAGE_ASSUMPTIONS);
+        endStage(STAGE_ASSUMPTIONS);
     }
 }
 
@@ -863,9 +1039,9 @@ int Encoding::solve() {
 }
 
 void Encoding::addUnitConstraint(int lit) {
-    _stats.begin(STAGE_FORBIDDENOPERATIONS);
+    beginStage(STAGE_FORBIDDENOPERATIONS);
     __interfaceSolver__addClause(lit);
-    _stats.end(STAGE_FORBIDDENOPERATIONS);
+    endStage(STAGE_FORBIDDENOPERATIONS);
 }
 
 float Encoding::getTimeSinceSatCallStart() {
@@ -933,8 +1109,24 @@ int Encoding::__interfaceSolver__encodeQConstantEqualityVar(int qconst1, int qco
     return var;
 }
 
+void Encoding::__interfaceSolver__registerAuxVars(int firstVar, const std::string& name) {
+    if (!_useSMTSolver) return;
+    for (int var = firstVar; var <= VariableDomain::getMaxVar(); var++) {
+        _smt.addVar(var, name + "_" + std::to_string(var), -1, -1);
+    }
+}
+
 
 int Encoding::__interfaceSolver__varSubstitution(int qConstId, int trueConstId) {
+    if (currentDeferredClauses != nullptr) {
+        // Variable may only be allocated when appending the deferred clauses
+        int var = _vars.getSubstitutionVariableOrZero(qConstId, trueConstId);
+        if (var != 0) return var;
+        auto [it, inserted] = currentDeferredClauses->newSubstitutionVars.emplace(IntPair(qConstId, trueConstId), currentDeferredClauses->newVars.size());
+        if (inserted) currentDeferredClauses->newVars.emplace_back(false, IntPair(qConstId, trueConstId));
+        return DEFERRED_VAR_OFFSET + it->second;
+    }
+
     int var = _vars.varSubstitution(qConstId, trueConstId);
 
     if (_useSMTSolver) {
@@ -949,6 +1141,10 @@ int Encoding::__interfaceSolver__varSubstitution(int qConstId, int trueConstId)
 
 
 void Encoding::__interfaceSolver__addClause(int lit) {
+    if (currentDeferredClauses != nullptr) {
+        currentDeferredClauses->lits.insert(currentDeferredClauses->lits.end(), {lit, 0});
+        return;
+    }
 
     if (_useSMTSolver) {
         _smt.addClause(lit);
@@ -958,6 +1154,10 @@ void Encoding::__interfaceSolver__addClause(int lit) {
 }
 
 void Encoding::__interfaceSolver__addClause(int lit1, int lit2) {
+    if (currentDeferredClauses != nullptr) {
+        currentDeferredClauses->lits.insert(currentDeferredClauses->lits.end(), {lit1, lit2, 0});
+        return;
+    }
 
     if (_useSMTSolver) {
         _smt.addClause(lit1, lit2);
@@ -968,6 +1168,10 @@ void Encoding::__interfaceSolver__addClause(int lit1, int lit2) {
 
 
 void Encoding::__interfaceSolver__addClause(int lit1, int lit2, int lit3) {
+    if (currentDeferredClauses != nullptr) {
+        currentDeferredClauses->lits.insert(currentDeferredClauses->lits.end(), {lit1, lit2, lit3, 0});
+        return;
+    }
 
     if (_useSMTSolver) {
         _smt.addClause(lit1, lit2, lit3);
@@ -977,6 +1181,11 @@ void Encoding::__interfaceSolver__addClause(int lit1, int lit2, int lit3) {
 }
 
 void Encoding::__interfaceSolver__addClause(const std::vector<int>& cls) {
+    if (currentDeferredClauses != nullptr) {
+        currentDeferredClauses->lits.insert(currentDeferredClauses->lits.end(), cls.begin(), cls.end());
+        currentDeferredClauses->lits.push_back(0);
+        return;
+    }
 
     if (_useSMTSolver) {
         _smt.addClause(cls);
@@ -987,6 +1196,10 @@ void Encoding::__interfaceSolver__addClause(const std::vector<int>& cls) {
 
 
 void Encoding::__interfaceSolver__appendClause(int lit) {
+    if (currentDeferredClauses != nullptr) {
+        currentDeferredClauses->lits.push_back(lit);
+        return;
+    }
 
     if (_useSMTSolver) {
         _smt.appendClause(lit);
@@ -996,6 +1209,10 @@ void Encoding::__interfaceSolver__appendClause(int lit) {
 }
 
 void Encoding::__interfaceSolver__appendClause(int lit1, int lit2) {
+    if (currentDeferredClauses != nullptr) {
+        currentDeferredClauses->lits.insert(currentDeferredClauses->lits.end(), {lit1, lit2});
+        return;
+    }
     
     if (_useSMTSolver) {
         _smt.appendClause(lit1, lit2);
@@ -1005,6 +1222,10 @@ void Encoding::__interfaceSolver__appendClause(int lit1, int lit2) {
 }
 
 void Encoding::__interfaceSolver__endClause() {
+    if (currentDeferredClauses != nullptr) {
+        currentDeferredClauses->lits.push_back(0);
+        return;
+    }
 
     if (_useSMTSolver) {
         _smt.endClause();
@@ -2,6 +2,8 @@
 #ifndef DOMPASCH_TREE_REXX_ENCODING_H
 #define DOMPASCH_TREE_REXX_ENCODING_H
 
+#include <tuple>
+
 #include "util/params.h"
 #include "data/layer.h"
 #include "data/signature.h"
@@ -18,7 +20,39 @@ typedef NodeHashMap<int, SigSet> State;
 
 class Encoding {
 
+public:
+    /*
+    Clauses of a single position which only refer to existing variables (or to
+    substitution and q-constant equality variables which are allocated later).
+    Such clauses are generated for many positions in parallel and then appended
+    to the solver in position order, so the formula does not depend on the scheduling.
+    */
+    struct DeferredClauses {
+        // Literals of all clauses, each clause terminated by 0.
+        std::vector<int> lits;
+        // Stage begin (true) and end (false) events, at a certain number of literals and at a certain time.
+        std::vector<std::tuple<size_t, int, bool, double>> stageEvents;
+        // Variables yet to be allocated: (is q-constant equality?, (q-constant, constant or q-constant)).
+        std::vector<std::pair<bool, IntPair>> newVars;
+        FlatHashMap<IntPair, int, IntPairHasher> newSubstitutionVars;
+        FlatHashMap<IntPair, int, IntPairHasher> newEqualityVars;
+    };
+
 private:
+    // Literals which refer to the n-th new variable of a DeferredClauses object
+    // are encoded as +/-(DEFERRED_VAR_OFFSET + n).
+    static const int DEFERRED_VAR_OFFSET = 1 << 30;
+
+    // Environment of a position whose clauses are deferred.
+    struct PositionContext {
+        size_t layerIdx;
+        size_t pos;
+        size_t oldPos;
+        size_t offset;
+        FlatHashSet<int> newFactVars;
+        DeferredClauses clauses;
+    };
+
     Parameters& _params;
     HtnInstance& _htn;
     FactAnalysis& _analysis;
@@ -48,11 +82,20 @@ private:
 
     const bool _use_q_constant_mutexes;
     const bool _implicit_primitiveness;
+    const bool _encode_fact_mutexes;
+    const bool _use_support_groups;
 
     const bool _useSMTSolver;
 
     float _sat_call_start_time;
 
+    // Number of threads generating deferred clauses (1: encode each position at once).
+    const int _num_threads;
+    std::vector<PositionContext> _deferred_positions;
+
+    // At-most-one encoding (AmoEncoding) as given by the -amo parameter.
+    const int _amo_encoding;
+
 public:
     Encoding(Parameters& params, HtnInstance& htn, FactAnalysis& analysis, std::vector<Layer*>& layers, std::function<void()> terminationCallback) : 
             _params(params), _htn(htn), _analysis(analysis), _layers(layers),
@@ -62,9 +105,20 @@ public:
             _decoder(_htn, _layers, _sat, _smt, _vars, _params.getIntParam("smt") > 0),
             _termination_callback(terminationCallback),
             _use_q_constant_mutexes(_params.getIntParam("qcm") > 0), 
-            _implicit_primitiveness(params.isNonzero("ip")) {}
+            _implicit_primitiveness(params.isNonzero("ip")), 
+            _encode_fact_mutexes(params.getIntParam("mtx") >= 2),
+            _use_support_groups(params.isNonzero("sga")),
+            _num_threads(getNumThreads(params)),
+            _amo_encoding(params.getIntParam("amo")) {
+        if (params.isSet("stage-profile")) _stats.setProfileOutput(params.getParam("stage-profile"));
+    }
 
+    // Encodes the given position. If clauses are deferred, only the variables and the clauses
+    // which may introduce further variables are encoded right away, and the remaining clauses
+    // are generated and added in encodeDeferredClauses.
     void encode(size_t layerIdx, size_t pos);
+    bool defersClauses() const {return _num_threads > 1;}
+    void encodeDeferredClauses();
     void addAssumptions(int layerIdx, bool permanent = false);
     void addUnitConstraint(int lit);
     
@@ -92,13 +146,22 @@ public:
     }
 
 private:
+    static int getNumThreads(Parameters& params);
+
+    void encodeRemainingClauses(Position& pos, const PositionContext& ctx);
+    void appendDeferredClauses(DeferredClauses& clauses);
+    void beginStage(int stage);
+    void endStage(int stage);
+
     void encodeOperationVariables(Position& pos);
     void encodeFactVariables(Position& pos, Position& left, Position& above);
     void encodeFrameAxioms(Position& pos, Position& left);
+    void encodeFactMutexes(Position& pos);
     void encodeIndirectFrameAxioms(const std::vector<int>& headerLits, int opVar, const IntPairTree& tree);
     void encodeOperationConstraints(Position& pos);
     void encodeSubstitutionVars(const USignature& opSig, int opVar, int qconst);
-    void encodeQFactSemantics(Position& pos);
+    void encodeAtMostOne(const std::vector<int>& vars, int stage);
+    void encodeQFactSemantics(Position& pos, const PositionContext& ctx);
     void encodeActionEffects(Position& pos, Position& left);
     void encodeQConstraints(Position& pos);
     void encodeSubtaskRelationships(Position& pos, Position& above);
@@ -112,6 +175,9 @@ private:
     int __interfaceSolver__encodeVarPrimitive(int layer, int pos);
     int __interfaceSolver__varSubstitution(int qConstId, int trueConstId);
     int __interfaceSolver__encodeQConstantEqualityVar(int qconst1, int qconst2);
+    // Declares the auxiliary variables firstVar, ..., VariableDomain::getMaxVar(),
+    // which were allocated by some encoding outside of this class.
+    void __interfaceSolver__registerAuxVars(int firstVar, const std::string& name);
 
     void __interfaceSolver__addClause(int lit);
     void __interfaceSolver__addClause(int lit1, int lit2);
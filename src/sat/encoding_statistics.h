@@ -4,9 +4,13 @@
 
 #include <vector>
 #include <map>
+#include <string>
+#include <chrono>
+#include <fstream>
 #include <assert.h>
 
 #include "util/log.h"
+#include "sat/at_most_one.h"
 
 const int STAGE_ACTIONCONSTRAINTS = 0;
 const int STAGE_ACTIONEFFECTS = 1;
@@ -29,6 +33,7 @@ const int STAGE_SUBSTITUTIONCONSTRAINTS = 17;
 const int STAGE_TRUEFACTS = 18;
 const int STAGE_ASSUMPTIONS = 19;
 const int STAGE_PLANLENGTHCOUNTING = 20;
+const int STAGE_FACTMUTEXES = 21;
 
 class EncodingStatistics {
 
@@ -43,12 +48,29 @@ public:
     long long int total_time_spend_on_solver_ms = 0;
 
 private:
-    const char* STAGES_NAMES[21] = {"actionconstraints","actioneffects","atleastoneelement","atmostoneelement",
+    const char* STAGES_NAMES[22] = {"actionconstraints","actioneffects","atleastoneelement","atmostoneelement",
         "axiomaticops","directframeaxioms","expansions","factpropagation","factvarencoding","forbiddenoperations",
         "indirectframeaxioms", "initsubstitutions","predecessors","qconstequality","qfactsemantics",
-        "qtypeconstraints","reductionconstraints","substitutionconstraints","truefacts","assumptions","planlengthcounting"};
+        "qtypeconstraints","reductionconstraints","substitutionconstraints","truefacts","assumptions","planlengthcounting",
+        "factmutexes"};
     std::vector<int> _num_cls_per_stage;
     std::vector<int> _current_stages;
+
+    // Clauses, literals, and time (summed over encoding threads) of a stage within a layer,
+    // excluding the nested stages
+    struct StageProfile {
+        int numCls = 0;
+        long long int numLits = 0;
+        double seconds = 0;
+    };
+    std::vector<std::vector<StageProfile>> _profile_per_layer;
+    size_t _layer = 0;
+    int _num_lits_at_stage_start = 0;
+    double _time_at_stage_start = 0;
+    // Base name of the CSV and JSON files to write the profile to (empty: none)
+    std::string _profile_basename;
+    // Stage -> number of at-most-one constraints per encoding
+    std::map<int, std::vector<int>> _num_amo_per_stage;
     int _num_cls_at_stage_start = 0;
 
 public:
@@ -66,31 +88,69 @@ public:
         Log::v("  Encoded %i cls, %i lits\n", _num_cls-_prev_num_cls, _num_lits-_prev_num_lits);
     }
 
-    void begin(int stage) {
+    // Monotonic time in seconds.
+    static double now() {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void setLayer(size_t layer) {
+        _layer = layer;
+    }
+
+    void setProfileOutput(const std::string& basename) {
+        _profile_basename = basename;
+    }
+
+    // The time of an event may be given explicitly if the stage was encoded earlier
+    // (e.g., by another thread) and its clauses are only added now.
+    void begin(int stage, double time = now()) {
         if (!_current_stages.empty()) {
             int oldStage = _current_stages.back();
-            _num_cls_per_stage[oldStage] += _num_cls - _num_cls_at_stage_start;
+            account(oldStage, time);
         }
         _num_cls_at_stage_start = _num_cls;
+        _num_lits_at_stage_start = _num_lits;
+        _time_at_stage_start = time;
         _current_stages.push_back(stage);
     }
 
-    void end(int stage) {
+    void end(int stage, double time = now()) {
         assert(!_current_stages.empty() && _current_stages.back() == stage);
         _current_stages.pop_back();
-        _num_cls_per_stage[stage] += _num_cls - _num_cls_at_stage_start;
+        account(stage, time);
         _num_cls_at_stage_start = _num_cls;
+        _num_lits_at_stage_start = _num_lits;
+        _time_at_stage_start = time;
+    }
+
+    void countAtMostOne(int stage, AmoEncoding encoding) {
+        auto& counts = _num_amo_per_stage[stage];
+        if (counts.empty()) counts.resize(NUM_AMO_ENCODINGS);
+        counts[encoding]++;
     }
 
     void printStages() {
         Log::i("Total amount of clauses encoded: %i\n", _num_cls);
-        std::map<int, int, std::greater<int>> stagesSorted;
+        std::vector<StageProfile> total(_num_cls_per_stage.size());
+        for (const auto& profile : _profile_per_layer) for (size_t stage = 0; stage < profile.size(); stage++) {
+            total[stage].numLits += profile[stage].numLits;
+            total[stage].seconds += profile[stage].seconds;
+        }
+        std::multimap<int, int, std::greater<int>> stagesSorted;
         for (size_t stage = 0; stage < _num_cls_per_stage.size(); stage++) {
             if (_num_cls_per_stage[stage] > 0)
-                stagesSorted[_num_cls_per_stage[stage]] = stage;
+                stagesSorted.emplace(_num_cls_per_stage[stage], stage);
         }
         for (const auto& [num, stage] : stagesSorted) {
-            Log::i("- %s : %i cls\n", STAGES_NAMES[stage], num);
+            Log::i("- %s : %i cls, %lli lits, %.4fs\n", STAGES_NAMES[stage], num, total[stage].numLits, total[stage].seconds);
+        }
+        if (!_profile_basename.empty() && !_profile_per_layer.empty()) writeProfile();
+        for (const auto& [stage, counts] : _num_amo_per_stage) {
+            Log::i("At-most-one encodings at %s:", STAGES_NAMES[stage]);
+            for (int e = AMO_PAIRWISE; e < NUM_AMO_ENCODINGS; e++) {
+                if (counts[e] > 0) Log::log_notime(Log::V2_INFORMATION, " %s=%i", AtMostOne::getName((AmoEncoding)e), counts[e]);
+            }
+            Log::log_notime(Log::V2_INFORMATION, "\n");
         }
         Log::i("Time spend on solver for each layer:\n");
         int layer = 0;
@@ -100,6 +160,8 @@ public:
         }
         Log::i("total time spend by the solver: %lli ms\n", total_time_spend_on_solver_ms);
         _num_cls_per_stage.clear();
+        _num_amo_per_stage.clear();
+        _profile_per_layer.clear();
     }
 
     ~EncodingStatistics() {
@@ -108,6 +170,40 @@ public:
         }
         
     }
+
+private:
+    void account(int stage, double time) {
+        _num_cls_per_stage[stage] += _num_cls - _num_cls_at_stage_start;
+        if (_profile_per_layer.size() <= _layer) _profile_per_layer.resize(_layer+1);
+        auto& profile = _profile_per_layer[_layer];
+        if (profile.empty()) profile.resize(_num_cls_per_stage.size());
+        profile[stage].numCls += _num_cls - _num_cls_at_stage_start;
+        profile[stage].numLits += _num_lits - _num_lits_at_stage_start;
+        profile[stage].seconds += time - _time_at_stage_start;
+    }
+
+    void writeProfile() {
+        std::ofstream csv(_profile_basename + ".csv");
+        std::ofstream json(_profile_basename + ".json");
+        csv << "layer,stage,clauses,literals,seconds\n";
+        json << "{\"layers\": [";
+        for (size_t layer = 0; layer < _profile_per_layer.size(); layer++) {
+            json << (layer > 0 ? "," : "") << "\n  {\"layer\": " << layer << ", \"stages\": {";
+            bool first = true;
+            const auto& profile = _profile_per_layer[layer];
+            for (size_t stage = 0; stage < profile.size(); stage++) {
+                const auto& p = profile[stage];
+                if (p.numCls == 0 && p.numLits == 0 && p.seconds == 0) continue;
+                csv << layer << "," << STAGES_NAMES[stage] << "," << p.numCls << "," << p.numLits << "," << p.seconds << "\n";
+                json << (first ? "" : ",") << "\n    \"" << STAGES_NAMES[stage] << "\": {\"clauses\": " << p.numCls 
+                    << ", \"literals\": " << p.numLits << ", \"seconds\": " << p.seconds << "}";
+                first = false;
+            }
+            json << "\n  }}";
+        }
+        json << "\n]}\n";
+        Log::i("Wrote encoding profile to %s.csv and %s.json\n", _profile_basename.c_str(), _profile_basename.c_str());
+    }
 };
 
 #endif
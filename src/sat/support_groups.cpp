@@ -0,0 +1,52 @@
+
+#include <algorithm>
+
+#include "support_groups.h"
+#include "variable_domain.h"
+#include "util/log.h"
+
+void SupportGroups::add(std::vector<int>&& cls, std::vector<int>&& supporters, std::vector<int>& cnf) {
+
+    if (!_enabled || supporters.size() < 2) {
+        cnf.insert(cnf.end(), cls.begin(), cls.end());
+        cnf.insert(cnf.end(), supporters.begin(), supporters.end());
+        cnf.push_back(0);
+        return;
+    }
+    std::sort(supporters.begin(), supporters.end());
+    auto it = _groups.find(supporters);
+    if (it == _groups.end()) _groups.emplace(supporters, IntPair(1, 0));
+    else it->second.first++;
+    _frame_axioms.emplace_back(std::move(cls), std::move(supporters));
+}
+
+size_t SupportGroups::encode(std::vector<int>& cnf) {
+
+    size_t numAuxVars = 0;
+    for (const auto& [cls, supporters] : _frame_axioms) {
+        auto& [numOccurrences, supportVar] = _groups[supporters];
+        size_t k = supporters.size();
+        size_t m = numOccurrences;
+        if (m + k+1 < m*k) {
+            // Refer to "some supporter occurs", defined once per support set
+            if (supportVar == 0) {
+                supportVar = VariableDomain::nextVar();
+                Log::d("VARMAP %i (__supp_%i_%i)\n", supportVar, supporters[0], (int)k);
+                numAuxVars++;
+                cnf.push_back(-supportVar);
+                cnf.insert(cnf.end(), supporters.begin(), supporters.end());
+                cnf.push_back(0);
+            }
+            cnf.insert(cnf.end(), cls.begin(), cls.end());
+            cnf.push_back(supportVar);
+        } else {
+            cnf.insert(cnf.end(), cls.begin(), cls.end());
+            cnf.insert(cnf.end(), supporters.begin(), supporters.end());
+        }
+        cnf.push_back(0);
+    }
+
+    _frame_axioms.clear();
+    _groups.clear();
+    return numAuxVars;
+}
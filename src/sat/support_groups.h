@@ -0,0 +1,35 @@
+
+#ifndef DOMPASCH_LILOTANE_SUPPORT_GROUPS_H
+#define DOMPASCH_LILOTANE_SUPPORT_GROUPS_H
+
+#include <vector>
+#include <cstddef>
+
+#include "util/hashmap.h"
+
+/*
+Encoding of the frame axioms of a position, each given as a clause without its direct
+supporters and the set of these supporters. If enabled, a set of at least two supporters
+which occurs in several frame axioms is replaced by an auxiliary variable implying that
+some supporter occurs, given that this results in fewer literals.
+*/
+class SupportGroups {
+
+private:
+    const bool _enabled;
+    std::vector<std::pair<std::vector<int>, std::vector<int>>> _frame_axioms;
+    FlatHashMap<std::vector<int>, IntPair, IntVecHasher> _groups; // -> (#occurrences, aux var)
+
+public:
+    SupportGroups(bool enabled) : _enabled(enabled) {}
+
+    // Adds the frame axiom (cls OR supporters). If the supporters cannot be grouped,
+    // the frame axiom is appended to cnf right away as a zero-terminated clause.
+    void add(std::vector<int>&& cls, std::vector<int>&& supporters, std::vector<int>& cnf);
+
+    // Appends all remaining frame axioms and the definitions of their auxiliary
+    // variables to cnf. Returns the number of introduced auxiliary variables.
+    size_t encode(std::vector<int>& cnf);
+};
+
+#endif
@@ -57,6 +57,7 @@ public:
 
         args[0] = qConstId;
         args[1] = trueConstId;
+        _sig_substitution.invalidateHash();
         return _sig_substitution;
     }
 
@@ -73,6 +74,12 @@ public:
         return var;
     }
 
+    // Read-only lookup which may be done concurrently.
+    int getSubstitutionVariableOrZero(int qConstId, int trueConstId) const {
+        auto it = _substitution_variables.find(USignature(_substitute_name_id, std::vector<int>{qConstId, trueConstId}));
+        return it == _substitution_variables.end() ? 0 : it->second;
+    }
+
     int encodeVarPrimitive(int layer, int pos) {
         return encodeVariable(VarType::OP, _layers.at(layer)->at(pos), _sig_primitive);
     }
@@ -91,6 +98,11 @@ public:
     int getQConstantEqualityVar(int qconst1, int qconst2) {
         return _q_equality_variables[IntPair(qconst1, qconst2)];
     }
+    // Read-only lookup which may be done concurrently.
+    int getQConstantEqualityVarOrZero(int qconst1, int qconst2) const {
+        auto it = _q_equality_variables.find(IntPair(qconst1, qconst2));
+        return it == _q_equality_variables.end() ? 0 : it->second;
+    }
 
     void skipVariable() {
         VariableDomain::nextVar();
@@ -0,0 +1,104 @@
+
+#include <assert.h>
+
+#include "util/timer.h"
+#include "util/log.h"
+#include "util/params.h"
+
+#include "algo/arg_iterator.h"
+
+// Reference: general mixed-radix enumeration as done before the arity specialization.
+size_t enumerateGeneric(int nameId, const std::vector<std::vector<int>>& eligibleArgs, size_t& checksum) {
+    size_t numChoices = eligibleArgs.empty() ? 0 : 1;
+    for (const auto& args : eligibleArgs) numChoices *= args.size();
+    if (numChoices == 0) return 0;
+
+    std::vector<size_t> counter(eligibleArgs.size(), 0);
+    USignature usig(nameId, std::vector<int>(eligibleArgs.size()));
+    for (size_t i = 0; i < usig._args.size(); i++) usig._args[i] = eligibleArgs[i].front();
+    for (size_t n = 0; n < numChoices; n++) {
+        checksum += usig._args.back();
+        for (size_t i = 0; i < counter.size(); i++) {
+            if (counter[i]+1 == eligibleArgs[i].size()) {
+                counter[i] = 0;
+                usig._args[i] = eligibleArgs[i].front();
+            } else {
+                counter[i]++;
+                usig._args[i] = eligibleArgs[i].at(counter[i]);
+                break;
+            }
+        }
+        usig.invalidateHash();
+    }
+    return numChoices;
+}
+
+int main(int argc, char** argv) {
+
+    Timer::init();
+
+    Parameters params;
+    params.init(argc, argv);
+
+    int verbosity = params.getIntParam("v");
+    Log::init(verbosity, /*coloredOutput=*/params.isNonzero("co"));
+
+    const int nameId = 42;
+    const size_t totalTuples = 20000000;
+
+    // Domain size per position for each arity, such that each run covers a similar number of tuples
+    const size_t domainSizes[] = {0, 1000, 100, 30, 10, 6};
+
+    for (size_t arity = 0; arity <= 5; arity++) {
+        std::vector<std::vector<int>> domains(arity);
+        for (size_t i = 0; i < arity; i++) {
+            for (size_t c = 0; c < domainSizes[arity]; c++) domains[i].push_back(c+1);
+        }
+        EligibleArgs eligibleArgs = std::make_shared<const std::vector<std::vector<int>>>(domains);
+
+        size_t tuplesPerRun = arity == 0 ? 0 : 1;
+        for (const auto& d : domains) tuplesPerRun *= d.size();
+        size_t numRuns = arity == 0 ? totalTuples : std::max((size_t)1, totalTuples / tuplesPerRun);
+
+        // Specialized iterator
+        size_t checksum = 0;
+        size_t numTuples = 0;
+        float time = Timer::elapsedSeconds();
+        for (size_t run = 0; run < numRuns; run++) {
+            for (const USignature& sig : ArgIterator(nameId, eligibleArgs)) {
+                checksum += sig._args.back();
+                numTuples++;
+            }
+        }
+        float specializedTime = Timer::elapsedSeconds() - time;
+
+        // Specialized enumeration with a single dispatch per call
+        size_t cbChecksum = 0;
+        size_t cbNumTuples = 0;
+        time = Timer::elapsedSeconds();
+        for (size_t run = 0; run < numRuns; run++) {
+            ArgIterator::forEach(nameId, *eligibleArgs, [&](const USignature& sig) {
+                cbChecksum += sig._args.back();
+                cbNumTuples++;
+                return true;
+            });
+        }
+        float callbackTime = Timer::elapsedSeconds() - time;
+
+        // Generic reference
+        size_t refChecksum = 0;
+        size_t refNumTuples = 0;
+        time = Timer::elapsedSeconds();
+        for (size_t run = 0; run < numRuns; run++) {
+            refNumTuples += enumerateGeneric(nameId, domains, refChecksum);
+        }
+        float genericTime = Timer::elapsedSeconds() - time;
+
+        assert(numTuples == refNumTuples);
+        assert(checksum == refChecksum);
+        assert(cbNumTuples == refNumTuples);
+        assert(cbChecksum == refChecksum);
+        Log::i("arity %i: %i runs, %i tuples: iterator %.4fs, forEach %.4fs, generic %.4fs\n",
+            arity, numRuns, numTuples, specializedTime, callbackTime, genericTime);
+    }
+}
@@ -96,6 +96,68 @@ int main(int argc, char** argv) {
         assert(numInstantiations == args1.size() * args2.size() * args3.size() * args4.size());
     }
 
+    {
+        // Arity above the specialized ones: all tuples in mixed-radix order
+        std::vector<std::vector<int>> eligibleArgs{{1, 2}, {3}, {4, 5, 6}, {7, 8}, {9, 10}};
+        std::vector<std::vector<int>> expected;
+        for (int e : eligibleArgs[4]) for (int d : eligibleArgs[3]) for (int c : eligibleArgs[2]) 
+            for (int b : eligibleArgs[1]) for (int a : eligibleArgs[0]) 
+                expected.push_back(std::vector<int>{a, b, c, d, e});
+
+        size_t numInstantiations = 0;
+        for (const auto& sig : ArgIterator(nameId, std::move(eligibleArgs))) {
+            assert(sig._args == expected[numInstantiations]);
+            numInstantiations++;
+        }
+        assert(numInstantiations == expected.size());
+    }
+
+    {
+        // Several iterators over the same shared domains
+        EligibleArgs eligibleArgs = std::make_shared<const std::vector<std::vector<int>>>(
+            std::vector<std::vector<int>>{{1, 2, 3}, {4, 5}});
+        ArgIterator first(nameId, eligibleArgs);
+        ArgIterator second(first);
+        size_t numInstantiations = 0;
+        for (const auto& sig : first) {
+            assert(sig._args.size() == 2);
+            numInstantiations++;
+        }
+        for (const auto& sig : second) {
+            assert(sig._args.size() == 2);
+            numInstantiations++;
+        }
+        assert(numInstantiations == 2 * 3 * 2);
+        assert(eligibleArgs.use_count() == 3);
+    }
+
+    {
+        // Enumeration via callback: same order as the iterator, stoppable
+        for (size_t arity = 0; arity <= 5; arity++) {
+            std::vector<std::vector<int>> eligibleArgs(arity);
+            for (size_t i = 0; i < arity; i++) eligibleArgs[i] = std::vector<int>{1, 2, 3};
+            std::vector<std::vector<int>> expected;
+            for (const auto& sig : ArgIterator(nameId, std::vector<std::vector<int>>(eligibleArgs))) {
+                expected.push_back(sig._args);
+            }
+            size_t numInstantiations = 0;
+            bool complete = ArgIterator::forEach(nameId, eligibleArgs, [&](const USignature& sig) {
+                assert(sig._name_id == nameId);
+                assert(sig._args == expected[numInstantiations]);
+                numInstantiations++;
+                return true;
+            });
+            assert(complete);
+            assert(numInstantiations == expected.size());
+
+            numInstantiations = 0;
+            complete = ArgIterator::forEach(nameId, eligibleArgs, [&](const USignature&) {
+                return ++numInstantiations < 2;
+            });
+            assert(complete == (expected.size() < 2));
+            assert(numInstantiations == std::min((size_t)2, expected.size()));
+        }
+    }
 
     /////// SampleArgIterator ////////
 
@@ -0,0 +1,71 @@
+
+#include <assert.h>
+
+#include "util/timer.h"
+#include "util/log.h"
+#include "util/params.h"
+
+#include "sat/variable_domain.h"
+#include "sat/at_most_one.h"
+#include "test/test_clauses.h"
+
+int main(int argc, char** argv) {
+
+    Timer::init();
+
+    Parameters params;
+    params.init(argc, argv);
+
+    int verbosity = params.getIntParam("v");
+    Log::init(verbosity, /*coloredOutput=*/params.isNonzero("co"));
+
+    // Each encoding admits exactly the assignments with at most one true variable,
+    // and its size is as estimated by the cost model
+    for (int e = AMO_PAIRWISE; e < NUM_AMO_ENCODINGS; e++) {
+        AmoEncoding encoding = (AmoEncoding)e;
+        for (size_t n = 0; n <= 9; n++) {
+            Log::d("%s, n=%i\n", AtMostOne::getName(encoding), n);
+
+            std::vector<int> vars;
+            for (size_t i = 0; i < n; i++) vars.push_back(VariableDomain::nextVar());
+            int firstAuxVar = VariableDomain::getMaxVar()+1;
+            auto cls = AtMostOne::encode(encoding, vars);
+            std::vector<int> auxVars;
+            for (int var = firstAuxVar; var <= VariableDomain::getMaxVar(); var++) auxVars.push_back(var);
+
+            AtMostOne::Cost cost = AtMostOne::estimate(encoding, n);
+            assert(cost.numClauses == cls.size());
+            assert(cost.numAuxVars == auxVars.size());
+
+            for (int values = 0; values < (1 << n); values++) {
+                int numTrue = 0;
+                for (size_t i = 0; i < n; i++) numTrue += (values >> i) & 0x1;
+                assert(isSatisfiable(cls, vars, values, auxVars) == (numTrue <= 1));
+            }
+        }
+    }
+
+    // Cost estimates for larger constraints
+    for (size_t n = 10; n <= 200; n++) {
+        for (int e = AMO_PAIRWISE; e < NUM_AMO_ENCODINGS; e++) {
+            AmoEncoding encoding = (AmoEncoding)e;
+            std::vector<int> vars;
+            for (size_t i = 0; i < n; i++) vars.push_back(VariableDomain::nextVar());
+            int firstAuxVar = VariableDomain::getMaxVar()+1;
+            auto cls = AtMostOne::encode(encoding, vars);
+            AtMostOne::Cost cost = AtMostOne::estimate(encoding, n);
+            assert(cost.numClauses == cls.size());
+            assert(cost.numAuxVars == (size_t)(VariableDomain::getMaxVar()+1-firstAuxVar));
+        }
+    }
+
+    // Automatic selection: pairwise for tiny constraints, linear-size encodings for large ones
+    for (size_t n = 0; n <= 4; n++) assert(AtMostOne::select(n) == AMO_PAIRWISE);
+    for (size_t n : {50, 200, 1000}) {
+        AmoEncoding encoding = AtMostOne::select(n);
+        Log::i("n=%i: %s\n", n, AtMostOne::getName(encoding));
+        assert(encoding != AMO_PAIRWISE && encoding != AMO_BINARY);
+    }
+
+    return 0;
+}
@@ -0,0 +1,58 @@
+
+#ifndef DOMPASCH_LILOTANE_TEST_CLAUSES_H
+#define DOMPASCH_LILOTANE_TEST_CLAUSES_H
+
+#include <assert.h>
+#include <cstdlib>
+#include <vector>
+
+// Value of a literal under an assignment whose i-th bit is the value of vars[i].
+inline bool evaluate(int lit, int values, const std::vector<int>& vars) {
+    for (size_t i = 0; i < vars.size(); i++) if (vars[i] == std::abs(lit)) {
+        bool val = (values >> i) & 0x1;
+        return lit > 0 ? val : !val;
+    }
+    assert(false);
+    return false;
+}
+
+// Is there an assignment to the auxiliary variables which satisfies all clauses
+// under the given assignment to the other variables?
+inline bool isSatisfiable(const std::vector<std::vector<int>>& cls, const std::vector<int>& vars, int values,
+        const std::vector<int>& auxVars) {
+
+    std::vector<int> allVars(vars);
+    allVars.insert(allVars.end(), auxVars.begin(), auxVars.end());
+    for (int auxValues = 0; auxValues < (1 << auxVars.size()); auxValues++) {
+        int allValues = values | (auxValues << vars.size());
+        bool sat = true;
+        for (const auto& c : cls) {
+            bool clsSat = false;
+            for (int lit : c) if (evaluate(lit, allValues, allVars)) {
+                clsSat = true;
+                break;
+            }
+            if (!clsSat) {
+                sat = false;
+                break;
+            }
+        }
+        if (sat) return true;
+    }
+    return false;
+}
+
+// Same for zero-terminated clauses.
+inline bool isSatisfiable(const std::vector<int>& cnf, const std::vector<int>& vars, int values,
+        const std::vector<int>& auxVars) {
+
+    std::vector<std::vector<int>> cls(1);
+    for (int lit : cnf) {
+        if (lit == 0) cls.emplace_back();
+        else cls.back().push_back(lit);
+    }
+    cls.pop_back();
+    return isSatisfiable(cls, vars, values, auxVars);
+}
+
+#endif
@@ -0,0 +1,100 @@
+
+#include <assert.h>
+
+#include "util/timer.h"
+#include "util/log.h"
+#include "util/params.h"
+#include "util/random.h"
+
+#include "sat/variable_domain.h"
+#include "sat/dnf2cnf.h"
+#include "test/test_clauses.h"
+
+const int NUM_VARS = 6;
+
+int main(int argc, char** argv) {
+
+    Timer::init();
+
+    Parameters params;
+    params.init(argc, argv);
+
+    int verbosity = params.getIntParam("v");
+    Log::init(verbosity, /*coloredOutput=*/params.isNonzero("co"));
+    Random::init(1, 1);
+
+    std::vector<int> vars;
+    for (int i = 0; i <= NUM_VARS; i++) vars.push_back(VariableDomain::nextVar());
+    int prefixVar = vars.back();
+
+    {
+        // Normalization: sorted literals, no duplicate or subsumed terms
+        std::vector<std::vector<int>> dnf {{3, 1, 3}, {2, 1}, {1, 3}, {4}, {4, 5}, {1, 3}};
+        Dnf2Cnf::normalize(dnf);
+        assert(dnf == (std::vector<std::vector<int>>{{4}, {1, 2}, {1, 3}}));
+    }
+
+    {
+        // Small DNFs are distributed
+        std::vector<std::vector<int>> dnf {{vars[0], vars[1]}, {vars[2]}};
+        std::vector<int> cnf;
+        assert(Dnf2Cnf::getCnf(dnf, {-prefixVar}, cnf) == 0);
+        assert(cnf == (std::vector<int>{-prefixVar, vars[0], vars[2], 0, -prefixVar, vars[1], vars[2], 0}));
+    }
+
+    for (int round = 0; round < 300; round++) {
+
+        // Random DNF over the variables (without the prefix variable)
+        std::vector<std::vector<int>> dnf(1 + (int)(Random::rand() * 4));
+        for (auto& term : dnf) {
+            size_t size = 1 + (int)(Random::rand() * 3);
+            for (size_t i = 0; i < size; i++) {
+                int lit = vars[(int)(Random::rand() * NUM_VARS)];
+                term.push_back(Random::rand() < 0.3 ? -lit : lit);
+            }
+        }
+        Dnf2Cnf::normalize(dnf);
+
+        // Automatic choice, auxiliary variables only, and default size guard
+        for (size_t maxDistributed : {(size_t)1000, (size_t)0, Dnf2Cnf::MAX_DISTRIBUTED_CLAUSES}) {
+            std::vector<int> cnf;
+            int firstAuxVar = VariableDomain::getMaxVar()+1;
+            size_t numAuxVars = Dnf2Cnf::getCnf(dnf, {-prefixVar}, cnf, maxDistributed);
+            std::vector<int> auxVars;
+            for (int var = firstAuxVar; var <= VariableDomain::getMaxVar(); var++) auxVars.push_back(var);
+            assert(numAuxVars == auxVars.size());
+            if (maxDistributed == 0) {
+                size_t numMultiLiteralTerms = 0;
+                for (const auto& term : dnf) if (term.size() > 1) numMultiLiteralTerms++;
+                assert(numAuxVars == numMultiLiteralTerms);
+            }
+
+            // (prefixVar -> dnf) must be equivalent to the CNF
+            for (int values = 0; values < (1 << vars.size()); values++) {
+                bool dnfHolds = false;
+                for (const auto& term : dnf) {
+                    bool termHolds = true;
+                    for (int lit : term) termHolds &= evaluate(lit, values, vars);
+                    dnfHolds |= termHolds;
+                }
+                bool expected = !evaluate(prefixVar, values, vars) || dnfHolds;
+                assert(isSatisfiable(cnf, vars, values, auxVars) == expected);
+            }
+        }
+    }
+
+    {
+        // Hard size guard: many terms result in a linear encoding
+        std::vector<std::vector<int>> dnf;
+        for (int i = 0; i < 40; i++) dnf.push_back(std::vector<int>{1000+2*i, 1001+2*i});
+        Dnf2Cnf::normalize(dnf);
+        std::vector<int> cnf;
+        size_t numAuxVars = Dnf2Cnf::getCnf(dnf, {-prefixVar}, cnf);
+        assert(numAuxVars == dnf.size());
+        size_t numClauses = 0;
+        for (int lit : cnf) if (lit == 0) numClauses++;
+        assert(numClauses == 1 + 2*dnf.size());
+    }
+
+    return 0;
+}
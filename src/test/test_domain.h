@@ -0,0 +1,160 @@
+
+#ifndef DOMPASCH_LILOTANE_TEST_DOMAIN_H
+#define DOMPASCH_LILOTANE_TEST_DOMAIN_H
+
+#include <string>
+#include <vector>
+
+#include "data/htn_instance.h"
+#include "util/params.h"
+#include "util/snapshot_io.h"
+
+/*
+A small transport domain without hierarchy, written as a snapshot of a preprocessed
+instance such that the static analyses can be tested without parsing a problem:
+Trucks drive along (directed) roads and load and unload packages. Truck t1 starts
+at l1 with package p1 and may reach l2 and l3; truck t2 is at l3, which no road
+leaves, and package p2 is at l4, which no road leads to or from.
+*/
+inline void writeTransportSnapshot(Parameters& params, const std::string& filename) {
+
+    std::vector<std::string> names {"truck", "location", "package",
+        "t1", "t2", "l1", "l2", "l3", "l4", "p1", "p2",
+        "at", "in", "package_at", "road",
+        "?t", "?from", "?to", "?p", "?l",
+        "drive", "load", "unload", "__BLANK___"};
+    auto id = [&](const std::string& name) {
+        for (size_t i = 0; i < names.size(); i++) if (names[i] == name) return (int)i+1;
+        abort();
+    };
+    auto sig = [&](const std::string& name, const std::vector<std::string>& args, bool negated = false) {
+        std::vector<int> argIds;
+        for (const auto& arg : args) argIds.push_back(id(arg));
+        return Signature(id(name), argIds, negated);
+    };
+
+    SnapshotWriter w;
+    w.write(params.getIntParam("psr"));
+    w.write(params.getIntParam("mp"));
+
+    w.write((int)names.size()+1);
+    w.write((uint64_t)names.size());
+    for (const auto& name : names) {
+        w.write(id(name));
+        w.write(name);
+    }
+    w.write(FlatHashSet<int>{id("?t"), id("?from"), id("?to"), id("?p"), id("?l")});
+    w.write(FlatHashSet<int>{id("at"), id("in"), id("package_at"), id("road")});
+    w.write(FlatHashSet<int>());
+
+    std::vector<std::pair<std::string, std::vector<std::string>>> sortsTable {
+        {"at", {"truck", "location"}}, {"in", {"package", "truck"}},
+        {"package_at", {"package", "location"}}, {"road", {"location", "location"}},
+        {"drive", {"truck", "location", "location"}}, {"load", {"package", "truck", "location"}},
+        {"unload", {"package", "truck", "location"}}, {"__BLANK___", {}}
+    };
+    w.write((uint64_t)sortsTable.size());
+    for (const auto& [name, sorts] : sortsTable) {
+        w.write(id(name));
+        std::vector<int> sortIds;
+        for (const auto& sort : sorts) sortIds.push_back(id(sort));
+        w.write(sortIds);
+    }
+    w.write(std::vector<int>{id("truck"), id("location"), id("package")});
+    w.write((uint64_t)3);
+    w.write(id("truck"));
+    w.write(FlatHashSet<int>{id("t1"), id("t2")});
+    w.write(id("location"));
+    w.write(FlatHashSet<int>{id("l1"), id("l2"), id("l3"), id("l4")});
+    w.write(id("package"));
+    w.write(FlatHashSet<int>{id("p1"), id("p2")});
+    w.write(std::vector<int>{id("t1"), id("t2"), id("l1"), id("l2"), id("l3"), id("l4"), id("p1"), id("p2")});
+
+    // No original task variables
+    w.write((uint64_t)0);
+
+    // Operators: signature, preconditions, extra preconditions, effects
+    w.write((uint64_t)4);
+    w.write(sig("drive", {"?t", "?from", "?to"})._usig);
+    w.write(SigSet{sig("at", {"?t", "?from"}), sig("road", {"?from", "?to"})});
+    w.write(SigSet());
+    w.write(SigSet{sig("at", {"?t", "?from"}, true), sig("at", {"?t", "?to"})});
+    w.write(sig("load", {"?p", "?t", "?l"})._usig);
+    w.write(SigSet{sig("package_at", {"?p", "?l"}), sig("at", {"?t", "?l"})});
+    w.write(SigSet());
+    w.write(SigSet{sig("package_at", {"?p", "?l"}, true), sig("in", {"?p", "?t"})});
+    w.write(sig("unload", {"?p", "?t", "?l"})._usig);
+    w.write(SigSet{sig("in", {"?p", "?t"}), sig("at", {"?t", "?l"})});
+    w.write(SigSet());
+    w.write(SigSet{sig("in", {"?p", "?t"}, true), sig("package_at", {"?p", "?l"})});
+    w.write(sig("__BLANK___", {})._usig);
+    w.write(SigSet());
+    w.write(SigSet());
+    w.write(SigSet());
+
+    // No methods, tasks, primitivizations or repetitions
+    for (int i = 0; i < 5; i++) w.write((uint64_t)0);
+
+    w.write(sig("__BLANK___", {})._usig);
+
+    std::vector<Signature> init {sig("at", {"t1", "l1"}), sig("at", {"t2", "l3"}),
+        sig("package_at", {"p1", "l1"}), sig("package_at", {"p2", "l4"}),
+        sig("road", {"l1", "l2"}), sig("road", {"l2", "l1"}), sig("road", {"l2", "l3"})};
+    w.write((uint64_t)init.size());
+    for (const auto& fact : init) w.write(fact._usig);
+    w.write(SigSet{sig("package_at", {"p1", "l3"})});
+
+    assert(w.writeToFile(filename));
+}
+
+struct GroundAction {
+    std::vector<USignature> posPre;
+    std::vector<USignature> negPre;
+    std::vector<USignature> add;
+    std::vector<USignature> del;
+};
+
+// All groundings of all action templates within the sorts of their arguments.
+inline std::vector<GroundAction> groundAllActions(HtnInstance& htn) {
+
+    std::vector<GroundAction> result;
+    for (const auto& [nameId, a] : htn.getActionTemplates()) {
+        const std::vector<int>& args = a.getArguments();
+        const std::vector<int>& sorts = htn.getSorts(nameId);
+        std::vector<std::vector<int>> domains;
+        for (int sort : sorts) {
+            const auto& constants = htn.getConstantsOfSort(sort);
+            domains.emplace_back(constants.begin(), constants.end());
+        }
+
+        std::vector<size_t> counters(args.size(), 0);
+        bool done = false;
+        for (const auto& domain : domains) done |= domain.empty();
+        while (!done) {
+            auto substitute = [&](const USignature& sig) {
+                USignature ground(sig);
+                for (int& arg : ground._args) for (size_t i = 0; i < args.size(); i++) {
+                    if (args[i] == arg) {
+                        arg = domains[i][counters[i]];
+                        break;
+                    }
+                }
+                ground.invalidateHash();
+                return ground;
+            };
+            GroundAction ga;
+            for (const Signature& pre : a.getPreconditions())
+                (pre._negated ? ga.negPre : ga.posPre).push_back(substitute(pre._usig));
+            for (const Signature& eff : a.getEffects())
+                (eff._negated ? ga.del : ga.add).push_back(substitute(eff._usig));
+            result.push_back(std::move(ga));
+
+            size_t k = 0;
+            while (k < counters.size() && ++counters[k] == domains[k].size()) counters[k++] = 0;
+            done = k == counters.size();
+        }
+    }
+    return result;
+}
+
+#endif
@@ -0,0 +1,91 @@
+
+#include <assert.h>
+#include <cstdio>
+#include <set>
+
+#include "util/timer.h"
+#include "util/log.h"
+#include "util/params.h"
+#include "util/names.h"
+
+#include "data/htn_instance.h"
+#include "algo/mutex_analysis.h"
+#include "test/test_domain.h"
+
+int main(int argc, char** argv) {
+
+    Timer::init();
+
+    Parameters params;
+    params.init(argc, argv);
+
+    int verbosity = params.getIntParam("v");
+    Log::init(verbosity, /*coloredOutput=*/params.isNonzero("co"));
+
+    std::string filename = "test_mutex_analysis.bin";
+    writeTransportSnapshot(params, filename);
+    params.setParam("snapshot-in", filename.c_str());
+    HtnInstance htn(params);
+    remove(filename.c_str());
+
+    MutexAnalysis mutexes(htn);
+    USigSet initState = htn.getInitState();
+    mutexes.compute(initState);
+    assert(mutexes.isComputed());
+
+    // A truck is at one location at a time; a package may be unloaded
+    // without being loaded before, so its locations are not mutex
+    assert(mutexes.hasInvariant(htn.nameId("at")));
+    int t1 = htn.nameId("t1"), t2 = htn.nameId("t2");
+    int l1 = htn.nameId("l1"), l3 = htn.nameId("l3");
+    assert(mutexes.areMutex(USignature(htn.nameId("at"), {t1, l1}), USignature(htn.nameId("at"), {t1, l3})));
+    assert(!mutexes.areMutex(USignature(htn.nameId("at"), {t1, l3}), USignature(htn.nameId("at"), {t2, l3})));
+    assert(!mutexes.hasInvariant(htn.nameId("package_at")));
+
+    // Explore all reachable states: no state contains two mutex facts
+    std::vector<GroundAction> actions = groundAllActions(htn);
+    std::vector<USignature> facts;
+    FlatHashMap<USignature, size_t, USignatureHasher> factIds;
+    for (const GroundAction& a : actions) {
+        for (const auto* sigs : {&a.posPre, &a.negPre, &a.add, &a.del}) for (const USignature& fact : *sigs) {
+            if (factIds.count(fact)) continue;
+            factIds[fact] = facts.size();
+            facts.push_back(fact);
+        }
+    }
+    for (const USignature& fact : initState) if (!factIds.count(fact)) {
+        factIds[fact] = facts.size();
+        facts.push_back(fact);
+    }
+
+    std::vector<bool> init(facts.size(), false);
+    for (const USignature& fact : initState) init[factIds[fact]] = true;
+    std::set<std::vector<bool>> visited {init};
+    std::vector<std::vector<bool>> open {init};
+    size_t numMutexPairs = 0;
+    while (!open.empty()) {
+        std::vector<bool> state = open.back();
+        open.pop_back();
+
+        for (size_t i = 0; i < facts.size(); i++) for (size_t j = i+1; j < facts.size(); j++) {
+            bool mutex = mutexes.areMutex(facts[i], facts[j]);
+            if (visited.size() == 1 && mutex) numMutexPairs++;
+            assert(!(state[i] && state[j] && mutex) || Log::e("%s and %s are mutex but hold together\n",
+                TOSTR(facts[i]), TOSTR(facts[j])));
+        }
+
+        for (const GroundAction& a : actions) {
+            bool applicable = true;
+            for (const USignature& pre : a.posPre) applicable &= state[factIds[pre]];
+            for (const USignature& pre : a.negPre) applicable &= !state[factIds[pre]];
+            if (!applicable) continue;
+            std::vector<bool> next = state;
+            for (const USignature& fact : a.del) next[factIds[fact]] = false;
+            for (const USignature& fact : a.add) next[factIds[fact]] = true;
+            if (visited.insert(next).second) open.push_back(std::move(next));
+        }
+    }
+    Log::i("%i reachable states, %i mutex pairs\n", visited.size(), numMutexPairs);
+    assert(visited.size() > 1);
+    assert(numMutexPairs > 0);
+}
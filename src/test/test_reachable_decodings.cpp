@@ -0,0 +1,75 @@
+
+#include <assert.h>
+#include <cstdio>
+#include <algorithm>
+
+#include "util/timer.h"
+#include "util/log.h"
+#include "util/params.h"
+
+#include "data/htn_instance.h"
+#include "algo/fact_analysis.h"
+#include "test/test_domain.h"
+
+int main(int argc, char** argv) {
+
+    Timer::init();
+
+    Parameters params;
+    params.init(argc, argv);
+
+    int verbosity = params.getIntParam("v");
+    Log::init(verbosity, /*coloredOutput=*/params.isNonzero("co"));
+
+    std::string filename = "test_reachable_decodings.bin";
+    writeTransportSnapshot(params, filename);
+    params.setParam("snapshot-in", filename.c_str());
+    HtnInstance htn(params);
+    remove(filename.c_str());
+
+    // Before any layer is instantiated, exactly the initial state is reachable
+    FactAnalysis analysis(htn);
+    int at = htn.nameId("at");
+    std::vector<std::vector<int>> eligibleArgs {
+        {htn.nameId("t1"), htn.nameId("t2")},
+        {htn.nameId("l1"), htn.nameId("l2"), htn.nameId("l3"), htn.nameId("l4")}
+    };
+    USignature qFact(at, std::vector<int>{htn.nameId("t1"), htn.nameId("l1")});
+
+    for (bool negated : {false, true}) {
+        for (size_t maxCollected : {(size_t)0, (size_t)1, (size_t)100}) {
+
+            // Brute force
+            std::vector<USignature> expected;
+            size_t expectedVariant = 0;
+            ArgIterator::forEach(at, eligibleArgs, [&](const USignature& decFact) {
+                if (!analysis.isReachable(decFact, negated)) return true;
+                expected.push_back(decFact);
+                if (analysis.isReachable(decFact, !negated)) expectedVariant++;
+                return true;
+            });
+
+            auto result = analysis.getReachableDecodings(qFact, eligibleArgs, negated, maxCollected);
+            assert(result.numReachable == expected.size());
+            assert(result.numVariant == expectedVariant);
+            assert(result.decodings.size() == std::min(maxCollected, expected.size()));
+            for (const USignature& decFact : result.decodings) {
+                assert(std::find(expected.begin(), expected.end(), decFact) != expected.end());
+            }
+
+            // Excluding the decodings at l1
+            int l1 = htn.nameId("l1");
+            size_t numAtL1 = 0;
+            for (const USignature& decFact : expected) if (decFact._args[1] == l1) numAtL1++;
+            result = analysis.getReachableDecodings(qFact, eligibleArgs, negated, maxCollected,
+                    [&](const USignature& decFact) {return decFact._args[1] == l1;});
+            assert(result.numReachable == expected.size() - numAtL1);
+            for (const USignature& decFact : result.decodings) assert(decFact._args[1] != l1);
+        }
+    }
+
+    // The initial positions of both trucks
+    auto result = analysis.getReachableDecodings(qFact, eligibleArgs, /*negated=*/false, 100);
+    assert(result.numReachable == 2);
+    assert(result.numVariant == 0);
+}
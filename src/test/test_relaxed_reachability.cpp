@@ -0,0 +1,82 @@
+
+#include <assert.h>
+#include <cstdio>
+
+#include "util/timer.h"
+#include "util/log.h"
+#include "util/params.h"
+#include "util/names.h"
+
+#include "data/htn_instance.h"
+#include "data/fact_index.h"
+#include "algo/relaxed_reachability.h"
+#include "test/test_domain.h"
+
+int main(int argc, char** argv) {
+
+    Timer::init();
+
+    Parameters params;
+    params.init(argc, argv);
+
+    int verbosity = params.getIntParam("v");
+    Log::init(verbosity, /*coloredOutput=*/params.isNonzero("co"));
+
+    std::string filename = "test_relaxed_reachability.bin";
+    writeTransportSnapshot(params, filename);
+    params.setParam("snapshot-in", filename.c_str());
+    HtnInstance htn(params);
+    remove(filename.c_str());
+
+    FactIndex index(htn);
+    RelaxedReachability reachability(htn, index);
+    USigSet initState = htn.getInitState();
+    reachability.compute(initState);
+    assert(reachability.isComputed());
+
+    // Brute-force delete-relaxed fixpoint over all ground actions
+    std::vector<GroundAction> actions = groundAllActions(htn);
+    USigSet reachable = initState;
+    USigSet deletable;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (const GroundAction& a : actions) {
+            bool applicable = true;
+            for (const USignature& pre : a.posPre) applicable &= reachable.count(pre) > 0;
+            if (!applicable) continue;
+            for (const USignature& fact : a.add) changed |= reachable.insert(fact).second;
+            for (const USignature& fact : a.del) deletable.insert(fact);
+        }
+    }
+
+    // Both agree on every ground fact of every predicate
+    size_t numFacts = 0;
+    for (int predId : htn.getPredicateIds()) {
+        std::vector<std::vector<int>> domains;
+        for (int sort : htn.getSorts(predId)) {
+            const auto& constants = htn.getConstantsOfSort(sort);
+            domains.emplace_back(constants.begin(), constants.end());
+        }
+        std::vector<size_t> counters(domains.size(), 0);
+        while (true) {
+            USignature fact(predId, std::vector<int>(domains.size()));
+            for (size_t i = 0; i < domains.size(); i++) fact._args[i] = domains[i][counters[i]];
+            long id = index.getId(fact);
+            Log::d("%s reachable=%i deletable=%i\n", TOSTR(fact), reachable.count(fact), deletable.count(fact));
+            assert(reachability.isReachable(fact, id) == (reachable.count(fact) > 0));
+            assert(reachability.isDeletable(fact, id) == (deletable.count(fact) > 0));
+            numFacts++;
+
+            size_t k = 0;
+            while (k < counters.size() && ++counters[k] == domains[k].size()) counters[k++] = 0;
+            if (k == counters.size()) break;
+        }
+    }
+    assert(numFacts == 8 + 4 + 8 + 16);
+
+    // The instance is not trivial: some facts are unreachable
+    assert(reachable.size() < numFacts);
+    assert(reachable.count(USignature(htn.nameId("package_at"), std::vector<int>{htn.nameId("p1"), htn.nameId("l3")})));
+    assert(!reachable.count(USignature(htn.nameId("at"), std::vector<int>{htn.nameId("t1"), htn.nameId("l4")})));
+}
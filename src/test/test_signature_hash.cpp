@@ -0,0 +1,91 @@
+
+#include <assert.h>
+
+#include "util/timer.h"
+#include "util/log.h"
+#include "util/params.h"
+
+#include "data/signature.h"
+#include "algo/arg_iterator.h"
+
+int main(int argc, char** argv) {
+
+    Timer::init();
+
+    Parameters params;
+    params.init(argc, argv);
+
+    int verbosity = params.getIntParam("v");
+    Log::init(verbosity, /*coloredOutput=*/params.isNonzero("co"));
+
+    USignatureHasher hasher;
+
+    {
+        USignature sig(1, std::vector<int>{2, 3, 4});
+        size_t hash = hasher(sig);
+        assert(hash == sig.computeHash());
+
+        // Copies and moves carry the cached value
+        USignature copy(sig);
+        assert(copy._hash == hash && copy == sig);
+        USignature moved(std::move(copy));
+        assert(moved._hash == hash && moved == sig);
+
+        // Mutations invalidate the cached value
+        Substitution s;
+        s[3] = 5;
+        sig.apply(s);
+        assert(hasher(sig) == sig.computeHash());
+        assert(sig != moved);
+        USignature renamed = moved.renamed(7);
+        assert(hasher(renamed) == renamed.computeHash());
+
+        USigSet set;
+        set.insert(moved);
+        assert(set.count(USignature(1, std::vector<int>{2, 3, 4})));
+        assert(!set.count(sig));
+    }
+
+    {
+        // Signatures produced by an ArgIterator must hash by their current arguments
+        std::vector<std::vector<int>> eligibleArgs{{1, 2, 3}, {4, 5}};
+        USigSet set;
+        for (const auto& sig : ArgIterator(42, std::move(eligibleArgs))) {
+            assert(hasher(sig) == sig.computeHash());
+            set.insert(sig);
+        }
+        assert(set.size() == 6);
+        assert(set.count(USignature(42, std::vector<int>{3, 5})));
+    }
+
+    /////// Repeated lookups of the same signatures ////////
+
+    {
+        const int numSigs = 10000;
+        const int numRounds = 50;
+        std::vector<USignature> sigs;
+        USigSet set;
+        for (int i = 0; i < numSigs; i++) {
+            sigs.emplace_back(i % 100, std::vector<int>{i, i+1, i+2, i+3, i+4});
+            set.insert(sigs.back());
+        }
+
+        size_t found = 0;
+        float time = Timer::elapsedSeconds();
+        for (int r = 0; r < numRounds; r++) for (auto& sig : sigs) {
+            sig.invalidateHash();
+            found += set.count(sig);
+        }
+        float timeUncached = Timer::elapsedSeconds() - time;
+
+        time = Timer::elapsedSeconds();
+        for (int r = 0; r < numRounds; r++) for (const auto& sig : sigs) {
+            found += set.count(sig);
+        }
+        float timeCached = Timer::elapsedSeconds() - time;
+
+        assert(found == 2 * numSigs * numRounds);
+        Log::i("%i lookups: %.4fs rehashing, %.4fs with cached hashes\n",
+            numSigs * numRounds, timeUncached, timeCached);
+    }
+}
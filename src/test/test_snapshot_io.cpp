@@ -0,0 +1,53 @@
+
+#include <assert.h>
+
+#include "util/timer.h"
+#include "util/log.h"
+#include "util/params.h"
+
+#include "util/snapshot_io.h"
+
+int main(int argc, char** argv) {
+
+    Timer::init();
+
+    Parameters params;
+    params.init(argc, argv);
+
+    int verbosity = params.getIntParam("v");
+    Log::init(verbosity, /*coloredOutput=*/params.isNonzero("co"));
+
+    std::string filename = "test_snapshot_io.bin";
+
+    USignature usig(3, std::vector<int>{4, 5, 6});
+    SigSet sigs;
+    sigs.insert(Signature(7, std::vector<int>{8}, /*negated=*/true));
+    sigs.insert(Signature(9, std::vector<int>{}));
+    FlatHashSet<int> ints{1, 2, 3, 100};
+
+    {
+        SnapshotWriter w;
+        w.write(42);
+        w.write(std::string("some name"));
+        w.write(std::vector<int>{1, -2, 3});
+        w.write(ints);
+        w.write(usig);
+        w.write(sigs);
+        assert(w.writeToFile(filename));
+    }
+
+    {
+        SnapshotReader r(filename);
+        assert(r.read<int>() == 42);
+        assert(r.readString() == "some name");
+        assert(r.readInts() == std::vector<int>({1, -2, 3}));
+        assert(r.readIntSet() == ints);
+        assert(r.readUSig() == usig);
+        SigSet readSigs = r.readSigSet();
+        assert(readSigs.size() == sigs.size());
+        for (const auto& sig : sigs) assert(readSigs.count(sig));
+        assert(r.atEnd());
+    }
+
+    remove(filename.c_str());
+}
@@ -0,0 +1,125 @@
+
+#include <assert.h>
+
+#include "util/timer.h"
+#include "util/log.h"
+#include "util/params.h"
+
+#include "data/substitution.h"
+#include "data/reduction.h"
+
+Reduction createReduction(int numArgs, int numSubtasks) {
+    std::vector<int> args;
+    for (int i = 1; i <= numArgs; i++) args.push_back(i);
+    std::vector<int> taskArgs(args.begin(), args.begin() + numArgs/2);
+    Reduction r(100, args, USignature(101, taskArgs));
+    for (int i = 0; i < numSubtasks; i++) {
+        std::vector<int> subArgs{args[i % numArgs], args[(i+1) % numArgs]};
+        r.addSubtask(USignature(200+i, std::move(subArgs)));
+        r.addPrecondition(Signature(300+i, std::vector<int>{args[(i+2) % numArgs]}));
+        r.addEffect(Signature(400+i, std::vector<int>{args[i % numArgs], args[(i+3) % numArgs]}, /*negated=*/i % 2 == 0));
+    }
+    return r;
+}
+
+int main(int argc, char** argv) {
+
+    Timer::init();
+
+    Parameters params;
+    params.init(argc, argv);
+
+    int verbosity = params.getIntParam("v");
+    Log::init(verbosity, /*coloredOutput=*/params.isNonzero("co"));
+
+    {
+        Substitution s;
+        assert(s.empty());
+        s[5] = 50;
+        s[1] = 10;
+        s[3] = 30;
+        assert(s.size() == 3);
+        assert(s[1] == 10 && s[3] == 30 && s[5] == 50);
+        assert(s.count(3) && !s.count(4));
+        assert(s.find(4) == s.end());
+        assert(s.find(5)->second == 50);
+
+        // Entries are sorted by key
+        int lastKey = 0;
+        for (const auto& [src, dest] : s) {
+            assert(src > lastKey);
+            lastKey = src;
+        }
+        s[3] = 33;
+        assert(s.size() == 3 && s.at(3) == 33);
+    }
+
+    {
+        // Exceed the inline capacity
+        Substitution s;
+        const int n = 3 * Substitution::INLINE_CAPACITY;
+        for (int i = n; i >= 1; i--) s[i] = -i;
+        assert(s.size() == (size_t)n);
+        for (int i = 1; i <= n; i++) assert(s.count(i) && s[i] == -i);
+        assert(!s.count(0) && !s.count(n+1));
+
+        Substitution copy(s);
+        assert(copy == s);
+        Substitution moved(std::move(copy));
+        assert(moved == s);
+        assert(copy.empty());
+        copy = moved;
+        assert(copy == s);
+        copy[n+1] = 0;
+        assert(copy != s);
+        assert(Substitution::Hasher()(moved) == Substitution::Hasher()(s));
+    }
+
+    {
+        std::vector<int> src{1, 2, 3};
+        std::vector<int> dest{4, 5, 3};
+        Substitution s(src, dest);
+        assert(s.size() == 2);
+        assert(s[1] == 4 && s[2] == 5 && !s.count(3));
+
+        Substitution t;
+        t[4] = 7;
+        t[6] = 8;
+        Substitution cat = s.concatenate(t);
+        assert(cat.size() == 4);
+        assert(cat[1] == 7 && cat[2] == 5 && cat[4] == 7 && cat[6] == 8);
+    }
+
+    {
+        std::vector<int> src{1, 1, 2};
+        std::vector<int> dest{3, 4, 5};
+        auto ss = Substitution::getAll(src, dest);
+        assert(ss.size() == 2);
+        for (const auto& s : ss) {
+            assert(s.size() == 2);
+            assert(s.count(1) && s[2] == 5);
+        }
+        assert(ss[0][1] != ss[1][1]);
+    }
+
+    /////// substituteRed throughput ////////
+
+    {
+        const int numArgs = 6;
+        const int numIterations = 200000;
+        Reduction r = createReduction(numArgs, 4);
+        std::vector<int> dest;
+        for (int i = 1; i <= numArgs; i++) dest.push_back(1000+i);
+
+        float time = Timer::elapsedSeconds();
+        size_t checksum = 0;
+        for (int it = 0; it < numIterations; it++) {
+            dest[it % numArgs] = 1000 + it;
+            Reduction sr = r.substituteRed(Substitution(r.getArguments(), dest));
+            checksum += sr.getSubtasks()[0]._args[0];
+        }
+        time = Timer::elapsedSeconds() - time;
+        assert(checksum > 0);
+        Log::i("substituteRed: %i substitutions in %.4fs (%.0f/s)\n", numIterations, time, numIterations / time);
+    }
+}
@@ -0,0 +1,73 @@
+
+#include <assert.h>
+#include <algorithm>
+
+#include "util/timer.h"
+#include "util/log.h"
+#include "util/params.h"
+#include "util/random.h"
+
+#include "sat/variable_domain.h"
+#include "sat/support_groups.h"
+#include "test/test_clauses.h"
+
+const int NUM_VARS = 7;
+
+int main(int argc, char** argv) {
+
+    Timer::init();
+
+    Parameters params;
+    params.init(argc, argv);
+
+    int verbosity = params.getIntParam("v");
+    Log::init(verbosity, /*coloredOutput=*/params.isNonzero("co"));
+    Random::init(1, 1);
+
+    std::vector<int> vars;
+    for (int i = 0; i < NUM_VARS; i++) vars.push_back(VariableDomain::nextVar());
+    auto randomVar = [&]() {return vars[(int)(Random::rand() * NUM_VARS)];};
+
+    size_t numGroupedRounds = 0;
+    for (int round = 0; round < 200; round++) {
+
+        // Frame axioms of one position, sharing a few sets of supporters
+        std::vector<std::vector<int>> supportSets(1 + (int)(Random::rand() * 3));
+        for (auto& supporters : supportSets) {
+            size_t size = 1 + (int)(Random::rand() * 4);
+            for (size_t i = 0; i < size; i++) {
+                int var = randomVar();
+                if (std::find(supporters.begin(), supporters.end(), var) == supporters.end()) supporters.push_back(var);
+            }
+        }
+        std::vector<std::pair<std::vector<int>, std::vector<int>>> frameAxioms(1 + (int)(Random::rand() * 8));
+        for (auto& [cls, supporters] : frameAxioms) {
+            size_t size = 1 + (int)(Random::rand() * 2);
+            for (size_t i = 0; i < size; i++) cls.push_back(Random::rand() < 0.5 ? -randomVar() : randomVar());
+            supporters = supportSets[(int)(Random::rand() * supportSets.size())];
+        }
+
+        // Encode the position with and without support groups
+        std::vector<int> cnfs[2];
+        std::vector<int> auxVars;
+        for (bool enabled : {false, true}) {
+            SupportGroups groups(enabled);
+            int firstAuxVar = VariableDomain::getMaxVar()+1;
+            for (auto [cls, supporters] : frameAxioms) groups.add(std::move(cls), std::move(supporters), cnfs[enabled]);
+            size_t numAuxVars = groups.encode(cnfs[enabled]);
+            for (int var = firstAuxVar; var <= VariableDomain::getMaxVar(); var++) auxVars.push_back(var);
+            assert(numAuxVars == auxVars.size());
+            if (!enabled) assert(numAuxVars == 0);
+        }
+        if (!auxVars.empty()) numGroupedRounds++;
+
+        // Both encodings are equisatisfiable under each assignment to the original variables
+        for (int values = 0; values < (1 << vars.size()); values++) {
+            assert(isSatisfiable(cnfs[0], vars, values, {}) == isSatisfiable(cnfs[1], vars, values, auxVars));
+        }
+    }
+    Log::i("%i/200 rounds with support group variables\n", numGroupedRounds);
+    assert(numGroupedRounds > 0);
+
+    return 0;
+}
@@ -6,15 +6,22 @@
 #include "util/log.h"
 
 NodeHashMap<int, std::string>* nbt;
+const QConstantRegistry* qcr;
 
 namespace Names {
     
-    void init(NodeHashMap<int, std::string>& nameBackTable) {
+    void init(NodeHashMap<int, std::string>& nameBackTable, const QConstantRegistry& qConstants) {
         nbt = &nameBackTable;
+        qcr = &qConstants;
     }
 
     std::string to_string(int nameId) {
         if (nameId <= 0) return std::to_string(nameId);
+        if (qcr != nullptr) {
+            // Names of q-constants and their sorts are only assembled on demand
+            if (qcr->isQConstant(nameId)) return qcr->getName(nameId, *nbt);
+            if (qcr->isQSort(nameId)) return qcr->getQSortName(nameId, *nbt);
+        }
         assert(nbt->count(nameId) || Log::e("No name known with ID %i!\n", nameId));
         return nbt->at(nameId);
     }
@@ -7,11 +7,12 @@
 #include "data/signature.h"
 #include "data/action.h"
 #include "data/fact_frame.h"
+#include "data/q_constant_registry.h"
 
 #define TOSTR(x) Names::to_string(x).c_str()
 
 namespace Names {
-    void init(NodeHashMap<int, std::string>& nameBackTable);
+    void init(NodeHashMap<int, std::string>& nameBackTable, const QConstantRegistry& qConstants);
     std::string to_string(int nameId);
     std::string to_string(const std::vector<int>& nameIds);
     std::string to_string(const std::vector<IntPair>& nameIds);
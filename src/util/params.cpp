@@ -38,6 +38,7 @@ void Parameters::init(int argc, char** argv) {
 
 void Parameters::setDefaults() {
     setParam("alo", "0"); // explicitly encode "at-least-one" over elements at each position
+    setParam("amo", "0"); // at-most-one encoding (-1: pairwise/binary by -bamot, 0: automatic, 1-5: forced)
     setParam("bamot", "50"); // Binary at-most-one threshold
     setParam("cleanup", "0"); // clean up before exit?
     setParam("co", "1"); // colored output
@@ -46,20 +47,27 @@ void Parameters::setDefaults() {
     setParam("D", "0"); // max depth (= num iterations)
     setParam("edo", "1"); // eliminate dominated operations
     setParam("el", "0"); // extra layers after initial solution (-1: expand indefinitely)
+    setParam("et", "1"); // encoding threads (0: all cores)
     setParam("ip", "0"); // implicit primitiveness
     setParam("mp", "2"); // mine preconditions
+    setParam("mtx", "1"); // static mutexes: 0=none, 1=prune, 2=prune and encode
     setParam("nps", "0"); // non-primitive fact supports
     setParam("of", "0"); // optimization factor
+    setParam("otc", "100000"); // op table cache size
     setParam("p", "1"); // encode predecessor operations
+    setParam("pfc", "0"); // precompute fact frames and fact changes at startup
     setParam("pvn", "0"); // print variable names
     setParam("qcm", "0"); // q-constant mutexes: size threshold
     setParam("plc", "0"); // print learnt clauses
     setParam("qit", "0"); // q-constant instantiation threshold
+    setParam("qja", "0"); // instantiate arguments by joining preconditions over reachable facts
     setParam("qrf", "0"); // q-constant rating factor
     setParam("q", "0"); // q-constants while always instantiating all preconditions
     setParam("qq", "1"); // q-constants without instantiation of preconditions
+    setParam("rrp", "1"); // relaxed reachability pre-pass
     setParam("s", "0"); // random seed
     setParam("sace", "0"); // split actions with (potentially) conflicting effects
+    setParam("sga", "1"); // support group auxiliaries in frame axioms
     setParam("sqq", "1"); // share q-constants
     setParam("srfa", "1"); // skip redundant frame axioms
     setParam("stats", "0"); // output domain statistics and exit
@@ -87,7 +95,9 @@ void Parameters::printUsage() {
     Log::i("\n");
     Log::i(" -aar=<0|1>          Acknowledge action repetitions and encode them in a reduced form\n");
     Log::i(" -alo=<0|1>          Explicitly encode at-least-one constraints over operations at each position\n");
-    Log::i(" -bamot=<int>        Binary at-most-one threshold\n");
+    Log::i(" -amo=<-1..5>        At-most-one encoding: -1 pairwise below -bamot and binary otherwise, 0 automatic selection,\n");
+    Log::i("                     1 pairwise, 2 binary, 3 ladder, 4 commander, 5 product\n");
+    Log::i(" -bamot=<int>        Binary at-most-one threshold (with -amo=-1)\n");
     Log::i(" -cleanup=<0|1>      0 to immediately exit through syscall after solution has been printed; 1 to exit normally\n");
     Log::i(" -co=<0|1>           Colored terminal output\n");
     Log::i(" -cs=<0|1>           Check solvability: When some layer is UNSAT, re-run SAT solver without assumptions\n");
@@ -95,28 +105,40 @@ void Parameters::printUsage() {
     Log::i(" -d=<depth>          Minimum depth to begin SAT solving at\n");
     Log::i(" -D=<depth>          Maximum depth to explore (0 : no limit)\n");
     Log::i(" -el=<int>           Number of extra layers to encode after an initial solution was found (use with -of=...)\n");
+    Log::i(" -et=<int>           Encoding threads: generate the clauses of a layer's positions in parallel (0: all cores)\n");
     Log::i(" -ip=<0|1>           Implicit primitiveness instead of defining each op as primitive XOR nonprimitive\n");
     Log::i(" -mp=<0|1|2>         Mine preconditions for reductions from their (recursive) subtasks:\n");
     Log::i("                     0=none, 1=use mined prec. for instantiation only, 2=use mined prec. everywhere\n");
+    Log::i(" -mtx=<0|1|2>        Static mutex detection: 0=none, 1=prune operations and q-fact decodings,\n");
+    Log::i("                     2=additionally encode mutexes among fact variables as binary clauses\n");
     Log::i(" -nps=<0|1>          Nonprimitive support: Enable encoding explicit fact supports for reductions\n");
     Log::i(" -of=<factor>        Plan length optimization factor: spend up to <factor> * <original solving time> for optimization\n");
     Log::i("                     (-1 for exhaustive optimization)\n");
+    Log::i(" -otc=<int>          Op table cache: max. number of materialized actions and reductions to keep (0: no limit)\n");
     Log::i(" -p=<0|1>            Encode predecessor operations\n");
+    Log::i(" -pfc=<0|1>          Precompute fact frames and possible fact changes of all operators at startup\n");
     Log::i(" -psr=<0|1>          Primitivize simple reductions\n");
     Log::i(" -pvn=<0|1>          Print variable names\n");
     Log::i(" -qcm=<limit>        Collect up to <limit> q-constant mutexes per tuple of q-constants\n");
     Log::i(" -qit=<threshold>    Q-constant instantiation threshold: fully instantiate up to <threshold> operations\n");
+    Log::i(" -qja=<0|1>          Without -qq, instantiate the arguments of each operation (all with neither -q nor -qq,\n");
+    Log::i("                     those in preconditions with -q) by joining its preconditions over the reachable facts\n");
     Log::i(" -qrf=<factor>       If -q or -qq, multiply precondition rating used for q-constant identification with <factor>\n");
     Log::i(" -q=<0|1>            For each action and reduction, introduces q-constants for any ambiguous free parameters\n");
     Log::i("                     after fully instantiating all preconditions\n");
     Log::i(" -qq=<0|1>           For each action and reduction, introduces q-constants for ALL ambiguous free parameters (replaces -q)\n");
+    Log::i(" -rrp=<0|1>          Relaxed reachability pre-pass: restrict reachable facts by a delete-relaxed fixpoint at startup\n");
     Log::i(" -s=<int>            Random seed\n");
+    Log::i(" -snapshot-in=<file> Load the preprocessed instance from a snapshot file (domain and problem files may be omitted)\n");
+    Log::i(" -snapshot-out=<file> Write the preprocessed instance to a snapshot file\n");
+    Log::i(" -sga=<0|1>          Replace sets of supporting operations shared by several frame axioms with an auxiliary variable\n");
     Log::i(" -sqq=<0|1>          Share q-constants among operations of a position if they have the same effective domain\n");
     Log::i(" -srfa=<0|1>         Skip redundant frame axioms\n");
+    Log::i(" -stage-profile=<file> Write clauses, literals and time per encoding stage and layer to <file>.csv and <file>.json\n");
     Log::i(" -stats=<0|1>        Output domain statistics and exit\n");
     Log::i(" -stl=<limit>        SAT time limit: Set limit in seconds for a SAT solver call. Limit is discarded after first such interrupt.\n");
     Log::i(" -T=<0|secs>         Try finding an initial plan for up to #secs (without optimization: total allowed runtime; 0: no limit)\n");
-    Log::i(" -tc=<0|1>           Use tree conversion for DNF 2 CNF transformation instead of distributive law\n");
+    Log::i(" -tc=<0|1>           Use tree conversion for DNF 2 CNF transformation instead of distributive law or auxiliary variables\n");
     Log::i(" -v=<verb>           Verbosity: 0=essential 1=warnings 2=information 3=verbose 4=debug\n");
     Log::i(" -vp=<0|1>           Verify plan (using pandaPIparser) before printing it\n");
     Log::i(" -wf=<0|1>           Write generated formula to text file \"f.cnf\" (with assumptions used in final call)\n");
@@ -0,0 +1,182 @@
+
+#ifndef DOMPASCH_LILOTANE_SNAPSHOT_IO_H
+#define DOMPASCH_LILOTANE_SNAPSHOT_IO_H
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "util/hashmap.h"
+#include "util/log.h"
+#include "data/signature.h"
+
+/*
+Plain binary (de)serialization of the basic data structures of an HTN instance.
+All integers are written in native byte order, so a snapshot file is only meant to be
+read on the machine (architecture) which wrote it. Each file begins with a magic
+string and a format version which are verified on reading.
+*/
+const char SNAPSHOT_MAGIC[8] = {'L', 'L', 'T', 'S', 'N', 'A', 'P', '\0'};
+const uint32_t SNAPSHOT_VERSION = 1;
+
+class SnapshotWriter {
+
+private:
+    std::vector<char> _buffer;
+
+public:
+    SnapshotWriter() {
+        _buffer.insert(_buffer.end(), SNAPSHOT_MAGIC, SNAPSHOT_MAGIC + sizeof(SNAPSHOT_MAGIC));
+        write(SNAPSHOT_VERSION);
+    }
+
+    template <typename T>
+    void write(const T& val) {
+        static_assert(std::is_trivially_copyable<T>::value);
+        const char* bytes = reinterpret_cast<const char*>(&val);
+        _buffer.insert(_buffer.end(), bytes, bytes + sizeof(T));
+    }
+    void write(const std::string& str) {
+        write((uint64_t)str.size());
+        _buffer.insert(_buffer.end(), str.begin(), str.end());
+    }
+    void write(const std::vector<int>& vec) {
+        write((uint64_t)vec.size());
+        const char* bytes = reinterpret_cast<const char*>(vec.data());
+        _buffer.insert(_buffer.end(), bytes, bytes + vec.size()*sizeof(int));
+    }
+    void write(const FlatHashSet<int>& set) {
+        write((uint64_t)set.size());
+        for (int i : set) write(i);
+    }
+    void write(const USignature& sig) {
+        write(sig._name_id);
+        write(sig._args);
+    }
+    void write(const Signature& sig) {
+        write(sig._usig);
+        write((uint8_t)sig._negated);
+    }
+    void write(const SigSet& set) {
+        write((uint64_t)set.size());
+        for (const Signature& sig : set) write(sig);
+    }
+
+    bool writeToFile(const std::string& filename) const {
+        FILE* f = fopen(filename.c_str(), "wb");
+        if (f == nullptr) return false;
+        bool success = fwrite(_buffer.data(), 1, _buffer.size(), f) == _buffer.size();
+        return fclose(f) == 0 && success;
+    }
+
+    size_t size() const {
+        return _buffer.size();
+    }
+};
+
+class SnapshotReader {
+
+private:
+    int _fd = -1;
+    const char* _data = nullptr;
+    size_t _size = 0;
+    size_t _offset = 0;
+
+public:
+    // Maps the given file into memory. Exits with an error message
+    // if the file cannot be read or is no valid snapshot.
+    SnapshotReader(const std::string& filename) {
+        _fd = open(filename.c_str(), O_RDONLY);
+        struct stat sb;
+        if (_fd < 0 || fstat(_fd, &sb) != 0 || !S_ISREG(sb.st_mode)) {
+            Log::e("Snapshot file \"%s\" cannot be read. Exiting.\n", filename.c_str());
+            exit(1);
+        }
+        _size = sb.st_size;
+        void* data = _size == 0 ? MAP_FAILED : mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, _fd, 0);
+        if (data == MAP_FAILED) {
+            Log::e("Snapshot file \"%s\" cannot be mapped into memory. Exiting.\n", filename.c_str());
+            exit(1);
+        }
+        _data = (const char*) data;
+
+        if (_size < sizeof(SNAPSHOT_MAGIC) || memcmp(_data, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0) {
+            Log::e("\"%s\" is not a snapshot file. Exiting.\n", filename.c_str());
+            exit(1);
+        }
+        _offset = sizeof(SNAPSHOT_MAGIC);
+        uint32_t version = read<uint32_t>();
+        if (version != SNAPSHOT_VERSION) {
+            Log::e("Snapshot file \"%s\" has version %u, expected version %u. Exiting.\n",
+                filename.c_str(), version, SNAPSHOT_VERSION);
+            exit(1);
+        }
+    }
+    ~SnapshotReader() {
+        if (_data != nullptr) munmap((void*)_data, _size);
+        if (_fd >= 0) close(_fd);
+    }
+
+    template <typename T>
+    T read() {
+        static_assert(std::is_trivially_copyable<T>::value);
+        T val;
+        memcpy(&val, advance(sizeof(T)), sizeof(T));
+        return val;
+    }
+    std::string readString() {
+        size_t size = read<uint64_t>();
+        return std::string(advance(size), size);
+    }
+    std::vector<int> readInts() {
+        size_t size = read<uint64_t>();
+        std::vector<int> vec(size);
+        memcpy(vec.data(), advance(size*sizeof(int)), size*sizeof(int));
+        return vec;
+    }
+    FlatHashSet<int> readIntSet() {
+        size_t size = read<uint64_t>();
+        FlatHashSet<int> set;
+        set.reserve(size);
+        for (size_t i = 0; i < size; i++) set.insert(read<int>());
+        return set;
+    }
+    USignature readUSig() {
+        int nameId = read<int>();
+        return USignature(nameId, readInts());
+    }
+    Signature readSig() {
+        USignature usig = readUSig();
+        bool negated = read<uint8_t>();
+        return Signature(std::move(usig), negated);
+    }
+    SigSet readSigSet() {
+        size_t size = read<uint64_t>();
+        SigSet set;
+        for (size_t i = 0; i < size; i++) set.insert(readSig());
+        return set;
+    }
+
+    bool atEnd() const {
+        return _offset == _size;
+    }
+
+private:
+    const char* advance(size_t numBytes) {
+        if (_offset + numBytes > _size) {
+            Log::e("Snapshot file is truncated. Exiting.\n");
+            exit(1);
+        }
+        const char* ptr = _data + _offset;
+        _offset += numBytes;
+        return ptr;
+    }
+};
+
+#endif